@@ -0,0 +1,30 @@
+#ifndef bench_h
+#define bench_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// keeps results alive so the compiler can not drop the measured code
+static volatile size_t bench_sink;
+
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static inline void bench_report(const char *name, uint64_t elapsed,
+                                size_t nops, size_t nbytes)
+{
+    double ns = (double)elapsed;
+
+    printf("%-40s %10.2f ns/op", name, ns / (double)nops);
+    if (nbytes) {
+        printf(" %10.2f MB/s", (double)nbytes * 1000.0 / ns);
+    }
+    printf("\n");
+}
+
+#endif
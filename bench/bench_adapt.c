@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 199309L
+#include "../src/utf8adapt.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFLEN (1024 * 1024)
+#define NLOOP  20
+// length of each string of the "tiny strings" corpus
+#define TINY 12
+
+//
+// Each kernel and the adaptive selection on corpora of different scripts.
+// Each corpus is built from random words of its vocabulary separated by
+// spaces, so the branches are not trivially predictable.
+//
+typedef struct {
+    const char *name;
+    const char *words[8];
+    // strings of TINY bytes are validated one by one
+    int tiny;
+} corpus_t;
+
+static const corpus_t CORPORA[] = {
+    {"ASCII log",
+     {"GET", "/index.html", "200", "[info]", "request", "user=42",
+      "2024-01-01T00:00:00Z", "latency_ms=17"},
+     0},
+    {"Latin (French)",
+     {"le", "caf\xC3\xA9", "\xC3\xA9t\xC3\xA9", "ann\xC3\xA9" "e", "pour",
+      "fa\xC3\xA7on", "tr\xC3\xA8s", "maison"},
+     0},
+    {"Cyrillic",
+     {"\xD0\xBF\xD1\x80\xD0\xB8", "\xD0\xB4\xD0\xB0",
+      "\xD1\x82\xD0\xB5\xD0\xBA\xD1\x81\xD1\x82",
+      "\xD0\xBC\xD0\xB8\xD1\x80", "\xD0\xB8", "\xD0\xB2",
+      "\xD0\xB3\xD0\xBE\xD0\xB4", "\xD0\xB4\xD0\xBE\xD0\xBC"},
+     0},
+    {"CJK",
+     {"\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E", "\xE4\xB8\xAD\xE6\x96\x87",
+      "\xE3\x83\x86\xE3\x82\xB9\xE3\x83\x88", "\xE3\x80\x82",
+      "\xE6\xBC\xA2\xE5\xAD\x97", "\xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4",
+      "\xE3\x81\x82", "\xEF\xBC\x8C"},
+     0},
+    {"emoji chat",
+     {"ok", "\xF0\x9F\x98\x82", "lol", "\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD",
+      "see", "you", "\xE2\x9D\xA4\xEF\xB8\x8F", "\xF0\x9F\x8E\x89"},
+     0},
+    {"tiny ASCII strings (12 bytes)",
+     {"id", "name", "key", "value", "x1", "count", "ok", "user"},
+     1},
+    {"tiny strings (12 bytes)",
+     {"id", "\xC3\xA9t\xC3\xA9", "name", "\xE6\x97\xA5", "key", "v", "x1",
+      "\xD0\xB4\xD0\xB0"},
+     1},
+};
+
+#define NCORPUS (sizeof(CORPORA) / sizeof(*CORPORA))
+
+static unsigned char buf[BUFLEN];
+
+static void fill(const corpus_t *c)
+{
+    size_t pos = 0;
+
+    srand(1);
+    while (pos < BUFLEN) {
+        const char *w = c->words[rand() % 8];
+        size_t len    = strlen(w);
+
+        if (pos + len + 1 > BUFLEN) {
+            memset(buf + pos, ' ', BUFLEN - pos);
+            break;
+        }
+        memcpy(buf + pos, w, len);
+        buf[pos + len] = ' ';
+        pos += len + 1;
+    }
+    // strings must not be cut inside a character
+    if (c->tiny) {
+        for (size_t i = 0; i < BUFLEN; i += TINY) {
+            size_t end = i + TINY;
+
+            while (end > i && utf8_validlen(buf + i, end - i) < end - i) {
+                buf[--end] = ' ';
+            }
+        }
+    }
+}
+
+static void run(const char *name, const corpus_t *c, int kernel)
+{
+    size_t step  = c->tiny ? TINY : BUFLEN;
+    size_t total = 0;
+    uint64_t t   = bench_now();
+
+    for (int n = 0; n < NLOOP; n++) {
+        for (size_t i = 0; i < BUFLEN; i += step) {
+            if (kernel < 0) {
+                total += utf8_validlen_adaptive(buf + i, step, NULL);
+            } else {
+                total += utf8_validlen_kernel(buf + i, step,
+                                              (utf8_kernel_t)kernel);
+            }
+        }
+    }
+    bench_sink = total;
+    bench_report(name, bench_now() - t, NLOOP, (size_t)BUFLEN * NLOOP);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < NCORPUS; i++) {
+        const corpus_t *c = &CORPORA[i];
+
+        fill(c);
+        if (utf8_validlen(buf, BUFLEN) != BUFLEN) {
+            return 1;
+        }
+        printf("=== %s ===\n", c->name);
+        run("scalar", c, UTF8_KERNEL_SCALAR);
+        run("ASCII skip", c, UTF8_KERNEL_ASCII);
+        run("DFA", c, UTF8_KERNEL_DFA);
+        run("adaptive", c, -1);
+    }
+    return 0;
+}
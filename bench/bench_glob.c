@@ -0,0 +1,119 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/utf8glob.h"
+#include "bench.h"
+#include <fnmatch.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NNAME 2000
+#define NLOOP 5
+
+//
+// Routing a set of file names through a set of glob rules: every name is
+// tested against every rule, with fnmatch() in the C locale (where '?'
+// matches a byte), fnmatch() in a UTF-8 locale, and precompiled utf8glob
+// patterns. The match counts differ where '?' meets a multibyte character.
+//
+static const char *RULES[] = {
+    "*.log",
+    "*.gz",
+    "logs/20?\?-?\?-?\?/*.log",
+    "data/\xE3\x83\x87\xE3\x83\xBC\xE3\x82\xBF/*.csv",
+    "[a-f]*.txt",
+    "*_[\xCE\xB1-\xCF\x89]*.json",
+    "?????.json",
+    "reports/*/\xE5\xA0\xB1\xE5\x91\x8A*.pdf",
+    "*[!0-9].bak",
+    "tmp/*",
+    "*/cache/*",
+    "\xD0\xB4\xD0\xBE\xD0\xBA\xD1\x83\xD0\xBC\xD0\xB5\xD0\xBD\xD1\x82*",
+    "img/*.[pj][np]g",
+    "*.tar.*",
+    "src/*.[ch]",
+    "*~",
+};
+
+#define NRULE (sizeof(RULES) / sizeof(*RULES))
+
+static const char *DIRS[]  = {"logs/2024-01-02/", "data/\xE3\x83\x87\xE3\x83"
+                                                  "\xBC\xE3\x82\xBF/",
+                              "reports/q1/", "tmp/", "src/", "img/",
+                              "home/user/cache/", ""};
+static const char *BASES[] = {"app", "\xE5\xA0\xB1\xE5\x91\x8A\xE6\x9B\xB8",
+                              "notes_\xCE\xB2", "\xD0\xB4\xD0\xBE\xD0\xBA"
+                                                "\xD1\x83\xD0\xBC\xD0\xB5"
+                                                "\xD0\xBD\xD1\x82",
+                              "a1", "file", "caf\xC3\xA9", "x"};
+static const char *EXTS[]  = {".log", ".csv", ".txt", ".json", ".pdf",
+                              ".png", ".c", ".tar.gz", ".bak", "~"};
+
+static char names[NNAME][96];
+static size_t lens[NNAME];
+
+static void run_fnmatch(const char *name)
+{
+    size_t total = 0;
+    uint64_t t   = bench_now();
+
+    for (int n = 0; n < NLOOP; n++) {
+        for (size_t i = 0; i < NNAME; i++) {
+            for (size_t r = 0; r < NRULE; r++) {
+                total += fnmatch(RULES[r], names[i], 0) == 0;
+            }
+        }
+    }
+    bench_sink = total;
+    bench_report(name, bench_now() - t, NLOOP * NNAME * NRULE, 0);
+    printf("%-40s %10zu matches\n", "", total / NLOOP);
+}
+
+int main(void)
+{
+    utf8_glob_t *globs[NRULE];
+    size_t total = 0;
+    uint64_t t   = 0;
+
+    srand(1);
+    for (size_t i = 0; i < NNAME; i++) {
+        snprintf(names[i], sizeof(names[i]), "%s%s%s", DIRS[rand() % 8],
+                 BASES[rand() % 8], EXTS[rand() % 10]);
+        lens[i] = strlen(names[i]);
+    }
+    for (size_t r = 0; r < NRULE; r++) {
+        globs[r] = utf8_glob_compile((const unsigned char *)RULES[r],
+                                     strlen(RULES[r]), 0);
+        if (!globs[r]) {
+            return 1;
+        }
+    }
+
+    printf("=== %d names against %d rules ===\n", NNAME, (int)NRULE);
+    run_fnmatch("fnmatch, C locale");
+    if (setlocale(LC_ALL, "C.UTF-8") || setlocale(LC_ALL, "en_US.UTF-8")) {
+        run_fnmatch("fnmatch, UTF-8 locale");
+        setlocale(LC_ALL, "C");
+    } else {
+        printf("(no UTF-8 locale)\n");
+    }
+
+    t = bench_now();
+    for (int n = 0; n < NLOOP; n++) {
+        for (size_t i = 0; i < NNAME; i++) {
+            for (size_t r = 0; r < NRULE; r++) {
+                total += utf8_glob_match(globs[r],
+                                         (const unsigned char *)names[i],
+                                         lens[i]) == 1;
+            }
+        }
+    }
+    bench_sink = total;
+    bench_report("utf8_glob_match, precompiled", bench_now() - t,
+                 NLOOP * NNAME * NRULE, 0);
+    printf("%-40s %10zu matches\n", "", total / NLOOP);
+
+    for (size_t r = 0; r < NRULE; r++) {
+        utf8_glob_free(globs[r]);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#define _POSIX_C_SOURCE 199309L
+#include "../src/utf8idna.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NROUNDS 200000
+
+// a hostname heavy workload: mostly ASCII with a few IDNs
+static const char *ASCII_HOSTS[] = {
+    "www.example.com",    "api.github.com",       "cdn.jsdelivr.net",
+    "mail.google.com",    "static.example.co.jp", "login.microsoftonline.com",
+    "images.example.org", "s3.amazonaws.com",
+};
+
+static const char *IDN_HOSTS[] = {
+    "www.m\xC3\xBC" "nchen.de",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E.jp",
+    "\xCF\x80\xCE\xB1\xCF\x81\xCE\xAC\xCE\xB4\xCE\xB5\xCE\xB9\xCE\xB3\xCE\xBC"
+    "\xCE\xB1.gr",
+    "b\xC3\xBC" "cher.example",
+};
+
+static const char *ACE_HOSTS[] = {
+    "www.xn--mnchen-3ya.de",
+    "xn--wgv71a119e.jp",
+    "xn--hxajbheg2az3al.gr",
+    "xn--bcher-kva.example",
+};
+
+static void run(const char *name, const char **hosts, size_t nhosts,
+                size_t (*fn)(unsigned char *, size_t, const unsigned char *,
+                             size_t))
+{
+    unsigned char buf[256];
+    size_t nbytes = 0;
+    size_t total  = 0;
+    uint64_t t    = bench_now();
+
+    for (size_t r = 0; r < NROUNDS; r++) {
+        for (size_t i = 0; i < nhosts; i++) {
+            size_t len = strlen(hosts[i]);
+            total += fn(buf, sizeof(buf), (const unsigned char *)hosts[i], len);
+            nbytes += len;
+        }
+    }
+    bench_report(name, bench_now() - t, NROUNDS * nhosts, nbytes);
+    bench_sink = total;
+}
+
+int main(void)
+{
+    printf("=== IDNA hostname conversion ===\n");
+    run("ToASCII: ASCII hostnames", ASCII_HOSTS,
+        sizeof(ASCII_HOSTS) / sizeof(*ASCII_HOSTS), utf8_idna_to_ascii);
+    run("ToASCII: IDN hostnames", IDN_HOSTS,
+        sizeof(IDN_HOSTS) / sizeof(*IDN_HOSTS), utf8_idna_to_ascii);
+    run("ToUnicode: ASCII hostnames", ASCII_HOSTS,
+        sizeof(ASCII_HOSTS) / sizeof(*ASCII_HOSTS), utf8_idna_to_unicode);
+    run("ToUnicode: ACE hostnames", ACE_HOSTS,
+        sizeof(ACE_HOSTS) / sizeof(*ACE_HOSTS), utf8_idna_to_unicode);
+    return 0;
+}
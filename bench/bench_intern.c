@@ -0,0 +1,76 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/utf8intern.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NTOPIC  1024
+#define NLOOKUP 2000000
+
+static char topics[NTOPIC][48];
+static size_t topiclen[NTOPIC];
+static utf8_intern_t *tab;
+
+typedef struct {
+    size_t nlookup;
+    int revalidate;
+} arg_t;
+
+static void *worker(void *p)
+{
+    arg_t *arg   = p;
+    size_t total = 0;
+
+    for (size_t i = 0; i < arg->nlookup; i++) {
+        const unsigned char *s = (const unsigned char *)topics[i % NTOPIC];
+        size_t len             = topiclen[i % NTOPIC];
+
+        // what callers did before: validate every lookup
+        if (arg->revalidate && utf8_validlen(s, len) != len) {
+            continue;
+        }
+        total += utf8_intern(tab, s, len)->flags;
+    }
+    bench_sink = total;
+    return NULL;
+}
+
+static void run(const char *name, int nthread, int revalidate)
+{
+    pthread_t threads[64];
+    arg_t arg  = {NLOOKUP / (size_t)nthread, revalidate};
+    uint64_t t = bench_now();
+
+    for (int i = 0; i < nthread; i++) {
+        pthread_create(&threads[i], NULL, worker, &arg);
+    }
+    for (int i = 0; i < nthread; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    bench_report(name, bench_now() - t, NLOOKUP, 0);
+}
+
+int main(void)
+{
+    static const int nthreads[] = {1, 2, 4, 8};
+    char name[64];
+
+    for (int i = 0; i < NTOPIC; i++) {
+        int len = snprintf(topics[i], sizeof(topics[i]),
+                           "orders.\xE6\xB3\xA8\xE6\x96\x87.region-%04d.events",
+                           i);
+        topiclen[i] = (size_t)len;
+    }
+    tab = utf8_intern_new(0);
+
+    printf("=== Interning of hot topic names (total time per lookup) ===\n");
+    for (size_t i = 0; i < sizeof(nthreads) / sizeof(*nthreads); i++) {
+        snprintf(name, sizeof(name), "validate + intern, %d threads",
+                 nthreads[i]);
+        run(name, nthreads[i], 1);
+        snprintf(name, sizeof(name), "intern only, %d threads", nthreads[i]);
+        run(name, nthreads[i], 0);
+    }
+    utf8_intern_free(tab);
+    return 0;
+}
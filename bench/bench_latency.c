@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 199309L
+#include "../src/utf8clen.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+// a buffer that fits in L1 so that only the latency of the calls is measured
+#define BUFLEN  4096
+#define NROUNDS 20000
+
+//
+// Latency of utf8clen() for each row of Table 3-7 and each illegal path.
+//
+// The calls form a dependent chain: each result advances the pointer that
+// is passed to the next call, as in a lexer, so their latencies add up
+// instead of overlapping. Each buffer repeats one sequence, so the branches
+// are predictable; the "mixed" rows show the cost of mispredictions.
+//
+typedef struct {
+    const char *name;
+    const char *seq;
+} seqclass_t;
+
+static const seqclass_t CLASSES[] = {
+    {"ASCII 00-7F", "a"},
+    {"C2-DF 80-BF", "\xC3\xA9"},
+    {"E0 A0-BF 80-BF", "\xE0\xA4\x85"},
+    {"E1-EC 80-BF 80-BF", "\xE3\x81\x82"},
+    {"ED 80-9F 80-BF", "\xED\x9F\xBF"},
+    {"EE-EF 80-BF 80-BF", "\xEF\xBC\xA1"},
+    {"F0 90-BF 80-BF 80-BF", "\xF0\x9F\x98\x82"},
+    {"F1-F3 80-BF 80-BF 80-BF", "\xF3\xA0\x80\x81"},
+    {"F4 80-8F 80-BF 80-BF", "\xF4\x8F\xBF\xBF"},
+    // illegal byte sequences, each consumed by a single call
+    {"illegal: C2-DF truncated", "\xC3"},
+    {"illegal: E0 overlong", "\xE0\x80\x80"},
+    {"illegal: E1-EC truncated", "\xE3\x81"},
+    {"illegal: ED surrogate", "\xED\xA0\x80"},
+    {"illegal: F0 overlong", "\xF0\x80\x80\x80"},
+    {"illegal: F1-F3 truncated", "\xF3\x80\x80"},
+    {"illegal: F4 above U+10FFFF", "\xF4\x90\x80\x80"},
+    // an illegal first byte swallows the following non-first bytes, so it
+    // is followed by an ASCII byte (two calls per sequence)
+    {"illegal: 80-BF + ASCII", "\x80" "a"},
+    {"illegal: C0-C1 + ASCII", "\xC0\x80" "a"},
+    {"illegal: F5-FF + ASCII", "\xFF" "a"},
+};
+
+#define NCLASS (sizeof(CLASSES) / sizeof(*CLASSES))
+
+static unsigned char buf[BUFLEN + 1];
+
+// fill the buffer with the sequences of the given classes, chosen at random
+// if there are more than one
+static void fill(const size_t *classes, size_t nclass)
+{
+    size_t pos = 0;
+
+    srand(1);
+    for (;;) {
+        const char *seq = CLASSES[classes[(size_t)rand() % nclass]].seq;
+        size_t len      = strlen(seq);
+
+        if (pos + len > BUFLEN) {
+            break;
+        }
+        memcpy(buf + pos, seq, len);
+        pos += len;
+    }
+    buf[pos] = 0;
+}
+
+static void run(const char *name)
+{
+    size_t ncall = 0;
+    size_t total = 0;
+    uint64_t t   = 0;
+
+    // count the calls of one round
+    for (const unsigned char *p = buf; *p; ncall++) {
+        size_t illlen = 0;
+        size_t len    = utf8clen(p, &illlen);
+        p += len ? len : illlen;
+    }
+
+    t = bench_now();
+    for (size_t r = 0; r < NROUNDS; r++) {
+        const unsigned char *p = buf;
+        while (*p) {
+            size_t illlen = 0;
+            size_t len    = utf8clen(p, &illlen);
+            p += len ? len : illlen;
+        }
+        total += (size_t)(p - buf);
+    }
+    bench_sink = total;
+    bench_report(name, bench_now() - t, ncall * NROUNDS, 0);
+}
+
+// the same chain with utf8clen_packed() and a single check per round
+static void run_packed(const char *name)
+{
+    const unsigned char *end = buf + strlen((const char *)buf);
+    size_t ncall             = 0;
+    size_t total             = 0;
+    uint64_t t               = 0;
+
+    for (const unsigned char *p = buf; p < end; ncall++) {
+        p += utf8clen_packed(p, (size_t)(end - p)) & UTF8CLEN_LEN_MASK;
+    }
+
+    t = bench_now();
+    for (size_t r = 0; r < NROUNDS; r++) {
+        const unsigned char *p = buf;
+        uint32_t all           = 0;
+        while (p < end) {
+            uint32_t res = utf8clen_packed(p, (size_t)(end - p));
+            all |= res;
+            p += res & UTF8CLEN_LEN_MASK;
+        }
+        total += (size_t)(p - buf) + !(all & UTF8CLEN_ILLEGAL);
+    }
+    bench_sink = total;
+    bench_report(name, bench_now() - t, ncall * NROUNDS, 0);
+}
+
+int main(void)
+{
+    static const size_t valid[]   = {0, 1, 3, 6};
+    static const size_t illegal[] = {0, 1, 3, 9, 12, 18};
+
+    printf("=== Latency of dependent utf8clen() calls (per call) ===\n");
+    for (size_t i = 0; i < NCLASS; i++) {
+        fill(&i, 1);
+        run(CLASSES[i].name);
+    }
+
+    fill(valid, sizeof(valid) / sizeof(*valid));
+    run("mixed: 1 to 4 byte characters");
+    run_packed("packed, mixed: 1 to 4 byte characters");
+    fill(illegal, sizeof(illegal) / sizeof(*illegal));
+    run("mixed: characters and illegal");
+    run_packed("packed, mixed: characters and illegal");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#define _GNU_SOURCE
+#include "../src/utf8parallel.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFLEN  (256 * 1024 * 1024)
+#define NLOOP   4
+#define NSTRIPE (BUFLEN / UTF8_PARALLEL_STRIPE)
+
+typedef size_t (*validate_t)(const unsigned char *, size_t, size_t);
+
+typedef struct {
+    unsigned char *buf;
+    size_t node;
+    size_t nnode;
+#if UTF8_PARALLEL_NUMA
+    cpu_set_t *cpus;
+#endif
+} filler_t;
+
+// text of mixed scripts, written to the stripes of one node so that their
+// pages are first touched there
+static void *fill(void *arg)
+{
+    filler_t *f = arg;
+
+#if UTF8_PARALLEL_NUMA
+    if (f->cpus) {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                               &f->cpus[f->node]);
+    }
+#endif
+    for (size_t i = 0; i < NSTRIPE; i++) {
+        // the same contiguous blocks as the placement of pages that are not
+        // resident in utf8_parallel_validlen_numa()
+        if (i * f->nnode / NSTRIPE != f->node) {
+            continue;
+        }
+        for (size_t pos = i * UTF8_PARALLEL_STRIPE;
+             pos < (i + 1) * UTF8_PARALLEL_STRIPE; pos += 16) {
+            memcpy(f->buf + pos,
+                   "text \xE3\x83\x86\xE3\x82\xAD\xE3\x82\xB9 ", 16);
+        }
+    }
+    return NULL;
+}
+
+// allocate the buffer and fill it from the main thread, or from a thread
+// pinned to each node if spread is set
+static unsigned char *alloc_buffer(int spread)
+{
+    filler_t fillers[UTF8_PARALLEL_MAXNODE];
+    pthread_t threads[UTF8_PARALLEL_MAXNODE];
+    unsigned char *buf = malloc(BUFLEN);
+    size_t nnode       = 1;
+
+    if (!buf) {
+        return NULL;
+    }
+#if UTF8_PARALLEL_NUMA
+    static cpu_set_t cpus[UTF8_PARALLEL_MAXNODE];
+    int ids[UTF8_PARALLEL_MAXNODE];
+
+    if (spread) {
+        nnode = utf8_parallel_nodes(cpus, ids);
+    }
+#else
+    (void)spread;
+#endif
+    if (nnode < 2) {
+        fillers[0] = (filler_t){.buf = buf, .nnode = 1};
+        fill(&fillers[0]);
+        return buf;
+    }
+    for (size_t n = 0; n < nnode; n++) {
+        fillers[n] = (filler_t){.buf = buf, .node = n, .nnode = nnode};
+#if UTF8_PARALLEL_NUMA
+        fillers[n].cpus = cpus;
+#endif
+        if (pthread_create(&threads[n], NULL, fill, &fillers[n])) {
+            fill(&fillers[n]);
+            threads[n] = pthread_self();
+        }
+    }
+    for (size_t n = 0; n < nnode; n++) {
+        if (!pthread_equal(threads[n], pthread_self())) {
+            pthread_join(threads[n], NULL);
+        }
+    }
+    return buf;
+}
+
+static void run(const char *name, validate_t fn, const unsigned char *buf,
+                size_t nthread)
+{
+    size_t total = 0;
+    uint64_t t   = bench_now();
+
+    for (int i = 0; i < NLOOP; i++) {
+        total += fn(buf, BUFLEN, nthread);
+    }
+    bench_sink = total;
+    bench_report(name, bench_now() - t, NLOOP, (size_t)BUFLEN * NLOOP);
+}
+
+int main(void)
+{
+    static const size_t nthreads[]  = {1, 2, 4, 8, 16, 32};
+    static const char *placements[] = {"on one node",
+                                       "spread over the nodes"};
+    size_t ncpu                     = utf8_parallel_nthread(0);
+    char name[64];
+
+    for (int spread = 0; spread < 2; spread++) {
+        unsigned char *buf = alloc_buffer(spread);
+
+        if (!buf) {
+            return 1;
+        }
+        printf("=== Parallel validation of %d MiB (per pass), pages %s "
+               "===\n",
+               BUFLEN / 1024 / 1024, placements[spread]);
+        for (size_t i = 0; i < sizeof(nthreads) / sizeof(*nthreads); i++) {
+            if (nthreads[i] > ncpu && i) {
+                break;
+            }
+            snprintf(name, sizeof(name), "even split, %zu threads",
+                     nthreads[i]);
+            run(name, utf8_parallel_validlen, buf, nthreads[i]);
+            snprintf(name, sizeof(name), "NUMA placement, %zu threads",
+                     nthreads[i]);
+            run(name, utf8_parallel_validlen_numa, buf, nthreads[i]);
+        }
+        free(buf);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#define _GNU_SOURCE
+#include "../src/utf8service.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PAYLOAD 512
+#define NREQ    20000
+#define BURST   32
+
+//
+// Latency and throughput of the validation service against inline
+// validation, for request threads that each validate NREQ payloads of
+// PAYLOAD bytes:
+//
+// - inline: each request thread calls utf8_validlen() itself
+// - service, sync: each request is submitted and waited for in turn, so
+//   the latency of a round trip through the service is measured
+// - service, burst: BURST requests are submitted before waiting for them,
+//   so the validator threads drain batches
+//
+// The latency columns are the median and 99th percentile of the time from
+// submission (or the start of inline validation) to the result.
+//
+
+typedef enum { MODE_INLINE, MODE_SYNC, MODE_BURST } client_mode_t;
+
+typedef struct {
+    utf8_service_t *svc;
+    client_mode_t mode;
+    const unsigned char *payload;
+    uint64_t *latency;
+    size_t total;
+} client_t;
+
+static void *client_main(void *arg)
+{
+    client_t *c = arg;
+    utf8_service_job_t jobs[BURST];
+    uint64_t start[BURST];
+
+    for (size_t n = 0; n < NREQ; n += BURST) {
+        size_t nburst = c->mode == MODE_BURST ? BURST : 1;
+
+        for (size_t b = 0; b < BURST; b += nburst) {
+            for (size_t i = 0; i < nburst; i++) {
+                start[i] = bench_now();
+                if (c->mode == MODE_INLINE) {
+                    c->total += utf8_validlen(c->payload, PAYLOAD);
+                } else {
+                    utf8_service_job_init(&jobs[i], c->payload, PAYLOAD, NULL,
+                                          NULL);
+                    utf8_service_submit(c->svc, &jobs[i]);
+                }
+            }
+            for (size_t i = 0; i < nburst; i++) {
+                if (c->mode != MODE_INLINE) {
+                    c->total += utf8_service_wait(c->svc, &jobs[i]);
+                }
+                c->latency[n + b + i] = bench_now() - start[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void run(const char *name, client_mode_t mode, size_t nclient,
+                size_t nvalidator, const unsigned char *payload)
+{
+    utf8_service_t *svc = mode == MODE_INLINE ? NULL
+                                              : utf8_service_new(nvalidator);
+    pthread_t *threads  = calloc(nclient, sizeof(*threads));
+    client_t *clients   = calloc(nclient, sizeof(*clients));
+    uint64_t *latency   = calloc(nclient * NREQ, sizeof(*latency));
+    size_t total        = 0;
+    uint64_t t          = 0;
+
+    if (!threads || !clients || !latency || (mode != MODE_INLINE && !svc)) {
+        exit(1);
+    }
+    t = bench_now();
+    for (size_t i = 0; i < nclient; i++) {
+        clients[i] = (client_t){.svc     = svc,
+                                .mode    = mode,
+                                .payload = payload,
+                                .latency = latency + i * NREQ};
+        pthread_create(&threads[i], NULL, client_main, &clients[i]);
+    }
+    for (size_t i = 0; i < nclient; i++) {
+        pthread_join(threads[i], NULL);
+        total += clients[i].total;
+    }
+    t = bench_now() - t;
+    utf8_service_free(svc);
+
+    bench_sink = total;
+    bench_report(name, t, nclient * NREQ, nclient * NREQ * PAYLOAD);
+    qsort(latency, nclient * NREQ, sizeof(*latency), cmp_u64);
+    printf("%-40s %10llu ns p50 %10llu ns p99\n", "",
+           (unsigned long long)latency[nclient * NREQ / 2],
+           (unsigned long long)latency[nclient * NREQ / 100 * 99]);
+    free(latency);
+    free(clients);
+    free(threads);
+}
+
+int main(void)
+{
+    static const size_t nclients[] = {1, 4, 16};
+    unsigned char payload[PAYLOAD];
+    char name[64];
+
+    // a JSON-like request body of mixed scripts
+    for (size_t pos = 0; pos < PAYLOAD; pos += 16) {
+        memcpy(payload + pos, "{\"k\":\"\xE3\x83\x86\xE3\x82\xAD\xC3\xA9\"} ",
+               16);
+    }
+
+    printf("=== Validation of %d-byte requests ===\n", PAYLOAD);
+    for (size_t i = 0; i < sizeof(nclients) / sizeof(*nclients); i++) {
+        size_t n = nclients[i];
+
+        snprintf(name, sizeof(name), "inline, %zu clients", n);
+        run(name, MODE_INLINE, n, 0, payload);
+        snprintf(name, sizeof(name), "service sync, %zu clients", n);
+        run(name, MODE_SYNC, n, 2, payload);
+        snprintf(name, sizeof(name), "service burst, %zu clients", n);
+        run(name, MODE_BURST, n, 2, payload);
+    }
+    return 0;
+}
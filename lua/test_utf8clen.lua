@@ -0,0 +1,49 @@
+local utf8clen = require('utf8clen')
+
+-- valid
+assert(utf8clen.valid('abc\227\129\130') == true)
+local ok, pos = utf8clen.valid('ab\255c')
+assert(ok == false and pos == 3)
+print('PASS: valid')
+
+-- count
+assert(utf8clen.count('a\227\129\130b') == 3)
+local n, ipos = utf8clen.count('a\237\160\128')
+assert(n == nil and ipos == 2)
+print('PASS: count')
+
+-- sanitize
+local s = 'hello \227\129\130'
+local res, replaced = utf8clen.sanitize(s)
+assert(res == s and replaced == false)
+res, replaced = utf8clen.sanitize('a\255b\237\160\128')
+assert(res == 'a\239\191\189b\239\191\189' and replaced == true)
+res, replaced = utf8clen.sanitize(string.rep('\227\129\130\255', 10000))
+assert(res == string.rep('\227\129\130\239\191\189', 10000) and replaced)
+print('PASS: sanitize')
+
+-- sub
+s = 'a\227\129\130b\227\129\132c'
+assert(utf8clen.sub(s, 2, 2) == '\227\129\130')
+assert(utf8clen.sub(s, 2) == '\227\129\130b\227\129\132c')
+assert(utf8clen.sub(s, -2) == '\227\129\132c')
+assert(utf8clen.sub(s, 1, -2) == 'a\227\129\130b\227\129\132')
+assert(utf8clen.sub(s, 4, 3) == '')
+assert(utf8clen.sub(s, 1, -6) == '')
+assert(utf8clen.sub(s, -10, 1) == 'a')
+assert(utf8clen.sub(s, 0) == s)
+print('PASS: sub')
+
+-- iter
+local list = {}
+for i, j, illegal in utf8clen.iter('a\227\129\130\255b') do
+    list[#list + 1] = string.format('%d-%d%s', i, j, illegal and '!' or '')
+end
+assert(table.concat(list, ',') == '1-1,2-4,5-5!,6-6')
+local next_char = utf8clen.iter('abc')
+assert(next_char('abc', 3) == nil)
+assert(next_char('abc', 4) == nil)
+assert(next_char('abc', 2 ^ 31) == nil)
+print('PASS: iter')
+
+print('\nAll tests passed successfully!')
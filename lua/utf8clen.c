@@ -0,0 +1,242 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+//
+// Lua 5.1-5.4 / LuaJIT binding of utf8clen.
+//
+// Every function works on a whole string with the bulk kernels of the
+// headers in src/, so a Lua loop never crosses into C once per character.
+// Strings that are already valid are returned as they are instead of
+// creating new Lua strings.
+//
+
+#include "../src/utf8escape.h"
+#include "../src/utf8sub.h"
+#include <lauxlib.h>
+#include <lua.h>
+
+#if LUA_VERSION_NUM < 502
+# define luaL_setfuncs(L, l, nup) luaL_register((L), NULL, (l))
+// Lua 5.1 buffers can not reserve a given size; the userdata is collected
+// like the buffer of later versions if an error is raised
+# define luaL_buffinitsize(L, b, sz)                                           \
+    (luaL_buffinit((L), (b)), (char *)lua_newuserdata((L), (sz)))
+# define luaL_pushresultsize(b, sz)                                            \
+    (lua_pushlstring((b)->L, (const char *)lua_touserdata((b)->L, -1),         \
+                     (sz)),                                                    \
+     lua_remove((b)->L, -2))
+#endif
+
+LUALIB_API int luaopen_utf8clen(lua_State *L);
+
+static const unsigned char *checkustring(lua_State *L, int idx, size_t *len)
+{
+    return (const unsigned char *)luaL_checklstring(L, idx, len);
+}
+
+// convert a 1-based character position (negative from the end) into a byte
+// offset of the start of that character
+static size_t posrelat(const unsigned char *s, size_t len, lua_Integer pos)
+{
+    if (pos > 0) {
+        return utf8_offset(s, len, (size_t)(pos - 1));
+    } else if (pos < 0) {
+        return utf8_roffset(s, len, (size_t)(-(pos + 1)) + 1);
+    }
+    return 0;
+}
+
+// convert a 1-based character position (negative from the end) into a byte
+// offset of the end of that character
+static size_t endrelat(const unsigned char *s, size_t len, lua_Integer pos)
+{
+    if (pos > 0) {
+        return utf8_offset(s, len, (size_t)pos);
+    } else if (pos == -1) {
+        return len;
+    } else if (pos < -1) {
+        return utf8_roffset(s, len, (size_t)(-(pos + 1)));
+    }
+    return 0;
+}
+
+/**
+ * valid(s)
+ * returns true, or false and the 1-based position of the first illegal
+ * byte sequence
+ */
+static int valid_lua(lua_State *L)
+{
+    size_t len             = 0;
+    const unsigned char *s = checkustring(L, 1, &len);
+    size_t pos             = utf8_validlen(s, len);
+
+    if (pos == len) {
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+    lua_pushboolean(L, 0);
+    lua_pushinteger(L, (lua_Integer)pos + 1);
+    return 2;
+}
+
+/**
+ * count(s)
+ * returns the number of characters, or nil and the 1-based position of the
+ * first illegal byte sequence
+ */
+static int count_lua(lua_State *L)
+{
+    size_t len             = 0;
+    const unsigned char *s = checkustring(L, 1, &len);
+    size_t pos             = utf8_validlen(s, len);
+
+    if (pos == len) {
+        lua_pushinteger(L, (lua_Integer)utf8_count(s, len));
+        return 1;
+    }
+    lua_pushnil(L);
+    lua_pushinteger(L, (lua_Integer)pos + 1);
+    return 2;
+}
+
+/**
+ * sanitize(s)
+ * returns s with each illegal byte sequence replaced with U+FFFD, and true
+ * if any sequence was replaced. s itself is returned if it is valid.
+ */
+static int sanitize_lua(lua_State *L)
+{
+    size_t len             = 0;
+    const unsigned char *s = checkustring(L, 1, &len);
+    size_t pos             = utf8_validlen(s, len);
+    size_t size            = 0;
+    unsigned char *buf     = NULL;
+    luaL_Buffer b;
+
+    if (pos == len) {
+        lua_settop(L, 1);
+        lua_pushboolean(L, 0);
+        return 2;
+    }
+
+    // the valid prefix has been checked already
+    size = pos + utf8_sanitize_size(s + pos, len - pos);
+    buf  = (unsigned char *)luaL_buffinitsize(L, &b, size);
+    memcpy(buf, s, pos);
+    utf8_sanitize(buf + pos, s + pos, len - pos);
+    luaL_pushresultsize(&b, size);
+    lua_pushboolean(L, 1);
+    return 2;
+}
+
+/**
+ * sub(s [, i [, j]])
+ * returns the substring of the characters i to j, like string.sub() but with
+ * character positions. s itself is returned if the result covers all of it.
+ */
+static int sub_lua(lua_State *L)
+{
+    size_t len             = 0;
+    const unsigned char *s = checkustring(L, 1, &len);
+    lua_Integer i          = luaL_optinteger(L, 2, 1);
+    lua_Integer j          = luaL_optinteger(L, 3, -1);
+    size_t head            = posrelat(s, len, i);
+    size_t tail            = endrelat(s, len, j);
+
+    if (head == 0 && tail == len) {
+        lua_settop(L, 1);
+    } else if (head >= tail) {
+        lua_pushliteral(L, "");
+    } else {
+        lua_pushlstring(L, (const char *)s + head, tail - head);
+    }
+    return 1;
+}
+
+static int iter_next_lua(lua_State *L)
+{
+    size_t len             = 0;
+    const unsigned char *s = checkustring(L, 1, &len);
+    lua_Integer prev       = luaL_checkinteger(L, 2);
+    size_t pos             = 0;
+    size_t clen            = 0;
+    size_t illlen          = 0;
+
+    // step over the previous character; the control value may be any
+    // integer if the iterator is called directly
+    if (prev > 0) {
+        if ((size_t)prev > len) {
+            return 0;
+        }
+        pos  = (size_t)prev - 1;
+        clen = utf8nclen(s + pos, len - pos, &illlen);
+        pos += clen ? clen : illlen;
+    }
+    if (pos >= len) {
+        return 0;
+    }
+
+    clen = utf8nclen(s + pos, len - pos, &illlen);
+    lua_pushinteger(L, (lua_Integer)pos + 1);
+    if (clen) {
+        lua_pushinteger(L, (lua_Integer)(pos + clen));
+        return 2;
+    }
+    lua_pushinteger(L, (lua_Integer)(pos + illlen));
+    lua_pushboolean(L, 1);
+    return 3;
+}
+
+/**
+ * iter(s)
+ * returns an iterator for the generic for statement that produces the
+ * 1-based start and end byte positions of each character, and true as the
+ * third value for an illegal byte sequence. No strings are created.
+ *
+ *  for i, j, illegal in utf8clen.iter(s) do ... end
+ */
+static int iter_lua(lua_State *L)
+{
+    checkustring(L, 1, NULL);
+    lua_pushcfunction(L, iter_next_lua);
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, 0);
+    return 3;
+}
+
+LUALIB_API int luaopen_utf8clen(lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"valid",    valid_lua   },
+        {"count",    count_lua   },
+        {"sanitize", sanitize_lua},
+        {"sub",      sub_lua     },
+        {"iter",     iter_lua    },
+        {NULL,       NULL        }
+    };
+
+    lua_newtable(L);
+    luaL_setfuncs(L, funcs, 0);
+    return 1;
+}
@@ -0,0 +1,255 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8adapt_h
+#define utf8adapt_h
+
+#include "utf8valid.h"
+
+//
+// Validation kernels and per-buffer kernel selection.
+//
+// The fastest way to validate a buffer depends on its content:
+//
+//  ASCII:  utf8_validlen(), which skips ASCII runs 8 bytes at a time. The
+//          fastest for ASCII-heavy text such as logs and source code.
+//  DFA:    a table-driven automaton that takes one load per byte, with no
+//          branch on the byte values. The fastest when ASCII runs are too
+//          short to skip (CJK, Cyrillic, and even Latin text with a few
+//          accents), as the branches of utf8nclen() mispredict.
+//  scalar: utf8nclen() on each character, as a baseline. It is not chosen
+//          automatically: in bench_adapt it is slower than one of the other
+//          kernels even on tiny strings.
+//
+// utf8_validlen_adaptive() skips the leading ASCII bytes, then samples the
+// share of all-ASCII 8-byte words in the next block and picks the kernel
+// for the rest of the buffer. Short buffers are not sampled; their first
+// word decides. The thresholds are in utf8_adapt_params_t. All kernels
+// return exactly what utf8_validlen() returns.
+//
+
+typedef enum {
+    UTF8_KERNEL_SCALAR,
+    UTF8_KERNEL_ASCII,
+    UTF8_KERNEL_DFA,
+} utf8_kernel_t;
+
+typedef struct {
+    // buffers shorter than this are not sampled
+    size_t small;
+    // number of bytes sampled
+    size_t sample;
+    // minimum percentage of all-ASCII words in the sample for the ASCII
+    // kernel, otherwise the DFA kernel is used
+    unsigned int ascii_pct;
+} utf8_adapt_params_t;
+
+#define UTF8_ADAPT_SMALL     64
+#define UTF8_ADAPT_SAMPLE    256
+#define UTF8_ADAPT_ASCII_PCT 50
+
+/**
+ * @brief Find the first illegal byte sequence with utf8nclen() only
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The offset of the first illegal byte sequence, or len if the whole
+ * buffer is valid
+ */
+static inline size_t utf8_validlen_scalar(const unsigned char *s, size_t len)
+{
+    size_t pos = 0;
+
+    while (pos < len) {
+        size_t illlen = 0;
+        size_t clen   = utf8nclen(s + pos, len - pos, &illlen);
+
+        if (clen == 0) {
+            break;
+        }
+        pos += clen;
+    }
+    return pos;
+}
+
+/**
+ * @brief Find the first illegal byte sequence with a DFA
+ *
+ * The automaton follows Table 3-7: each state is the set of bytes that may
+ * follow, and any other byte leads to the reject state.
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The offset of the first illegal byte sequence, or len if the whole
+ * buffer is valid
+ */
+static inline size_t utf8_validlen_dfa(const unsigned char *s, size_t len)
+{
+    // byte classes: 00-7F, 80-8F, 90-9F, A0-BF, illegal, C2-DF, E0,
+    // E1-EC and EE-EF, ED, F0, F1-F3, F4
+    static const uint8_t cls[256] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 00-0F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 10-1F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 20-2F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 30-3F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 40-4F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 50-5F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 60-6F
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 70-7F
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 80-8F
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, // 90-9F
+        3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, // A0-AF
+        3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, // B0-BF
+        4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, // C0-CF
+        5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, // D0-DF
+        6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 7, // E0-EF
+        9, 10, 10, 10, 11, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // F0-FF
+    };
+    static const uint8_t next[9 * 12] = {
+          0,  12,  12,  12,  12,  24,  60,  36,  72,  84,  48,  96, // accept
+         12,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12, // reject
+         12,   0,   0,   0,  12,  12,  12,  12,  12,  12,  12,  12, // 1 more
+         12,  24,  24,  24,  12,  12,  12,  12,  12,  12,  12,  12, // 2 more
+         12,  36,  36,  36,  12,  12,  12,  12,  12,  12,  12,  12, // 3 more
+         12,  12,  12,  24,  12,  12,  12,  12,  12,  12,  12,  12, // after E0
+         12,  24,  24,  12,  12,  12,  12,  12,  12,  12,  12,  12, // after ED
+         12,  12,  36,  36,  12,  12,  12,  12,  12,  12,  12,  12, // after F0
+         12,  36,  12,  12,  12,  12,  12,  12,  12,  12,  12,  12, // after F4
+    };
+    size_t state = 0;
+    // start of the current character
+    size_t start = 0;
+
+    // states are multiplied by the number of classes
+    for (size_t i = 0; i < len; i++) {
+        state = next[state + cls[s[i]]];
+        if (state == 12) {
+            return start;
+        }
+        start = state ? start : i + 1;
+    }
+    return state ? start : len;
+}
+
+/**
+ * @brief Pick the kernel for a buffer
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param params Pointer to the thresholds, or NULL for the defaults
+ *
+ * @return The kernel to use
+ */
+static inline utf8_kernel_t utf8_adapt_choose(const unsigned char *s,
+                                              size_t len,
+                                              const utf8_adapt_params_t *params)
+{
+    static const utf8_adapt_params_t defaults = {
+        .small     = UTF8_ADAPT_SMALL,
+        .sample    = UTF8_ADAPT_SAMPLE,
+        .ascii_pct = UTF8_ADAPT_ASCII_PCT,
+    };
+    size_t nword  = 0;
+    size_t nascii = 0;
+
+    if (!params) {
+        params = &defaults;
+    }
+    if (len < params->small) {
+        uint64_t v;
+
+        // too short to amortize a sample: the first word decides
+        if (len < 8) {
+            return UTF8_KERNEL_DFA;
+        }
+        memcpy(&v, s, 8);
+        return v & UINT64_C(0x8080808080808080) ? UTF8_KERNEL_DFA
+                                                 : UTF8_KERNEL_ASCII;
+    }
+    nword = (len < params->sample ? len : params->sample) / 8;
+
+    // words of 8 ASCII bytes, which the ASCII kernel skips at once
+    for (size_t i = 0; i < nword; i++) {
+        uint64_t v;
+        memcpy(&v, s + i * 8, 8);
+        nascii += !(v & UINT64_C(0x8080808080808080));
+    }
+    return nascii * 100 >= (size_t)params->ascii_pct * nword
+               ? UTF8_KERNEL_ASCII
+               : UTF8_KERNEL_DFA;
+}
+
+/**
+ * @brief Find the first illegal byte sequence with a given kernel
+ */
+static inline size_t utf8_validlen_kernel(const unsigned char *s, size_t len,
+                                          utf8_kernel_t kernel)
+{
+    switch (kernel) {
+    case UTF8_KERNEL_SCALAR:
+        return utf8_validlen_scalar(s, len);
+    case UTF8_KERNEL_DFA:
+        return utf8_validlen_dfa(s, len);
+    default:
+        return utf8_validlen(s, len);
+    }
+}
+
+/**
+ * @brief Find the first illegal byte sequence with the kernel that suits the
+ * start of the buffer
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param params Pointer to the thresholds, or NULL for the defaults
+ *
+ * @return The offset of the first illegal byte sequence, or len if the whole
+ * buffer is valid, or SIZE_MAX if parameters are invalid (and errno is set
+ * to EINVAL)
+ */
+static inline size_t utf8_validlen_adaptive(const unsigned char *s,
+                                            size_t len,
+                                            const utf8_adapt_params_t *params)
+{
+    size_t small = params ? params->small : UTF8_ADAPT_SMALL;
+    size_t pos   = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    // the choice is made where the first non-ASCII byte is
+    if (len >= small) {
+        pos = utf8_asciilen(s, len);
+        if (pos == len) {
+            return len;
+        }
+    }
+    return pos + utf8_validlen_kernel(s + pos, len - pos,
+                                      utf8_adapt_choose(s + pos, len - pos,
+                                                        params));
+}
+
+#endif
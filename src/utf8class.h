@@ -0,0 +1,367 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8class_h
+#define utf8class_h
+
+#include "utf8cp.h"
+#include "utf8valid.h"
+
+//
+// Character classes compiled to byte automata.
+//
+// A set of code point ranges is split into ranges of UTF-8 byte sequences
+// that have the same length and differ only in the last bytes, e.g.
+// U+0400-U+04FF becomes [D0-D3][80-BF]. This is the decomposition of
+// Table 3-7: a range is cut where the encoded length changes, around the
+// surrogates, and wherever a byte other than the last would not cover its
+// whole continuation range. The sequences are inserted into a byte-level
+// automaton, so a character is matched with one table lookup per byte and
+// is never decoded. Illegal byte sequences never match.
+//
+// utf8_class_find() skips bytes that cannot start a match before running
+// the automaton: if all characters of the class share one lead byte, it
+// jumps between occurrences of that byte with memchr(), which the C library
+// vectorizes; if the class has no ASCII characters, ASCII runs are skipped
+// 8 bytes at a time. Lead bytes and ASCII bytes always start a character
+// (or an illegal byte sequence) as utf8clen() splits the input, so no
+// match is missed.
+//
+
+// the automaton has at most this many states
+#define UTF8_CLASS_MAXSTATE 65535
+
+// transitions to these states end a match
+#define UTF8_CLASS_REJECT 0
+#define UTF8_CLASS_ACCEPT 1
+#define UTF8_CLASS_START  2
+
+typedef struct {
+    uint32_t lo;
+    uint32_t hi;
+} utf8_cprange_t;
+
+typedef struct {
+    // next[state][byte], for states 0 to nstate - 1
+    uint16_t (*next)[256];
+    size_t nstate;
+    size_t cap;
+    // the only lead byte of all characters, or -1
+    int lead;
+    // whether any ASCII character is in the class
+    int ascii;
+} utf8_class_t;
+
+/**
+ * @brief Free a compiled class
+ */
+static inline void utf8_class_free(utf8_class_t *cls)
+{
+    if (cls) {
+        free(cls->next);
+        free(cls);
+    }
+}
+
+/**
+ * @brief Add an empty state to a class
+ *
+ * @return The new state, or 0 if out of memory
+ */
+static inline uint16_t utf8_class_state(utf8_class_t *cls)
+{
+    if (cls->nstate == UTF8_CLASS_MAXSTATE) {
+        return 0;
+    }
+    if (cls->nstate == cls->cap) {
+        size_t cap = cls->cap * 2;
+        uint16_t(*next)[256] = realloc(cls->next, cap * sizeof(*next));
+
+        if (!next) {
+            return 0;
+        }
+        cls->next = next;
+        cls->cap  = cap;
+    }
+    memset(cls->next[cls->nstate], 0, sizeof(*cls->next));
+    return (uint16_t)cls->nstate++;
+}
+
+/**
+ * @brief Insert a range of byte sequences of length n into the automaton
+ *
+ * @return 0 on success, or -1 if out of memory
+ */
+static inline int utf8_class_insert(utf8_class_t *cls, uint16_t state,
+                                    const unsigned char *lo,
+                                    const unsigned char *hi, size_t n)
+{
+    unsigned int b = lo[0];
+
+    while (b <= hi[0]) {
+        uint16_t t     = cls->next[state][b];
+        unsigned int e = b;
+
+        // bytes that lead to the same state share its suffixes
+        while (e < hi[0] && cls->next[state][e + 1] == t) {
+            e++;
+        }
+        if (n == 1) {
+            t = UTF8_CLASS_ACCEPT;
+        } else if (t == UTF8_CLASS_REJECT) {
+            t = utf8_class_state(cls);
+            if (!t) {
+                return -1;
+            }
+        }
+        for (unsigned int k = b; k <= e; k++) {
+            cls->next[state][k] = t;
+        }
+        if (n > 1 && utf8_class_insert(cls, t, lo + 1, hi + 1, n - 1) != 0) {
+            return -1;
+        }
+        b = e + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Split a code point range into byte sequence ranges and insert them
+ *
+ * @return 0 on success, or nonzero if out of memory
+ */
+static inline int utf8_class_split(utf8_class_t *cls, uint32_t lo,
+                                   uint32_t hi)
+{
+    static const uint32_t ends[] = {0x7F, 0x7FF, 0xFFFF};
+    unsigned char elo[4] = {0};
+    unsigned char ehi[4] = {0};
+    size_t n = 0;
+
+    // no range crosses a change of length or the surrogates
+    for (size_t i = 0; i < sizeof(ends) / sizeof(*ends); i++) {
+        if (lo <= ends[i] && hi > ends[i]) {
+            return utf8_class_split(cls, lo, ends[i]) ||
+                   utf8_class_split(cls, ends[i] + 1, hi);
+        }
+    }
+    if (lo <= 0xDFFF && hi >= 0xD800) {
+        return (lo < 0xD800 && utf8_class_split(cls, lo, 0xD7FF)) ||
+               (hi > 0xDFFF && utf8_class_split(cls, 0xE000, hi));
+    }
+
+    // only the last bytes may be partial ranges of continuation bytes
+    for (unsigned int i = 1; i < 4; i++) {
+        uint32_t m = (UINT32_C(1) << (6 * i)) - 1;
+
+        if ((lo & ~m) != (hi & ~m)) {
+            if (lo & m) {
+                return utf8_class_split(cls, lo, lo | m) ||
+                       utf8_class_split(cls, (lo | m) + 1, hi);
+            }
+            if ((hi & m) != m) {
+                return utf8_class_split(cls, lo, (hi & ~m) - 1) ||
+                       utf8_class_split(cls, hi & ~m, hi);
+            }
+        }
+    }
+
+    n = utf8_encode(elo, lo);
+    utf8_encode(ehi, hi);
+    return utf8_class_insert(cls, UTF8_CLASS_START, elo, ehi, n);
+}
+
+static inline int utf8_class_cmp(const void *a, const void *b)
+{
+    const utf8_cprange_t *x = a;
+    const utf8_cprange_t *y = b;
+
+    return (x->lo > y->lo) - (x->lo < y->lo);
+}
+
+/**
+ * @brief Compile a set of code point ranges
+ *
+ * Ranges may overlap and be in any order. Surrogates U+D800-U+DFFF are not
+ * characters, and are left out of the ranges.
+ *
+ * @param ranges Pointer to the ranges (inclusive)
+ * @param nrange Number of ranges
+ *
+ * @return Pointer to the class, to be freed with utf8_class_free(), or NULL
+ * if a range is invalid (and errno is set to EINVAL) or out of memory (and
+ * errno is set to ENOMEM)
+ */
+static inline utf8_class_t *utf8_class_compile(const utf8_cprange_t *ranges,
+                                               size_t nrange)
+{
+    utf8_cprange_t *sorted = NULL;
+    utf8_class_t *cls       = NULL;
+    size_t n                = 0;
+    int lead                = -1;
+
+    if (!ranges && nrange) {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (size_t i = 0; i < nrange; i++) {
+        if (ranges[i].lo > ranges[i].hi || ranges[i].hi > 0x10FFFF) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+    sorted = malloc((nrange ? nrange : 1) * sizeof(*sorted));
+    cls    = calloc(1, sizeof(*cls));
+    if (cls) {
+        cls->cap  = 16;
+        cls->next = malloc(cls->cap * sizeof(*cls->next));
+    }
+    if (!sorted || !cls || !cls->next) {
+        free(sorted);
+        utf8_class_free(cls);
+        errno = ENOMEM;
+        return NULL;
+    }
+    // reject, accept and start
+    for (int i = 0; i < 3; i++) {
+        utf8_class_state(cls);
+    }
+
+    // merge overlapping and adjacent ranges, so that each sequence range
+    // is inserted into a part of the automaton that no other one shares
+    if (nrange) {
+        memcpy(sorted, ranges, nrange * sizeof(*sorted));
+        qsort(sorted, nrange, sizeof(*sorted), utf8_class_cmp);
+    }
+    for (size_t i = 0; i < nrange; i++) {
+        if (n && sorted[i].lo <= sorted[n - 1].hi + 1) {
+            if (sorted[i].hi > sorted[n - 1].hi) {
+                sorted[n - 1].hi = sorted[i].hi;
+            }
+        } else {
+            sorted[n++] = sorted[i];
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (utf8_class_split(cls, sorted[i].lo, sorted[i].hi) != 0) {
+            free(sorted);
+            utf8_class_free(cls);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    free(sorted);
+
+    // prefilters
+    for (unsigned int b = 0; b < 256; b++) {
+        if (cls->next[UTF8_CLASS_START][b] != UTF8_CLASS_REJECT) {
+            cls->ascii |= b <= 0x7F;
+            lead = lead == -1 ? (int)b : -2;
+        }
+    }
+    cls->lead = lead >= 0 ? lead : -1;
+    return cls;
+}
+
+/**
+ * @brief Match the character at the start of a buffer
+ *
+ * @param cls Pointer to a compiled class
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The length of the character (1-4) if it is in the class, or 0
+ */
+static inline size_t utf8_class_match(const utf8_class_t *cls,
+                                      const unsigned char *s, size_t len)
+{
+    size_t state = UTF8_CLASS_START;
+
+    for (size_t i = 0; i < len && i < 4; i++) {
+        state = cls->next[state][s[i]];
+        if (state <= UTF8_CLASS_ACCEPT) {
+            return state == UTF8_CLASS_ACCEPT ? i + 1 : 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the first character of a buffer that is in a class
+ *
+ * The buffer is split into characters and illegal byte sequences as
+ * utf8clen() splits it.
+ *
+ * @param cls Pointer to a compiled class
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param mlen Pointer to a size_t that receives the length of the
+ * character, or NULL
+ *
+ * @return The offset of the character, or len if no character is in the
+ * class, or SIZE_MAX if parameters are invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_class_find(const utf8_class_t *cls,
+                                     const unsigned char *s, size_t len,
+                                     size_t *mlen)
+{
+    size_t pos = 0;
+
+    if (!cls || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    while (pos < len) {
+        size_t m      = 0;
+        size_t illlen = 0;
+        size_t clen   = 0;
+
+        if (cls->lead >= 0) {
+            const unsigned char *p = memchr(s + pos, cls->lead, len - pos);
+
+            if (!p) {
+                break;
+            }
+            pos = (size_t)(p - s);
+        } else if (!cls->ascii) {
+            pos += utf8_asciilen(s + pos, len - pos);
+            if (pos == len) {
+                break;
+            }
+        }
+
+        m = utf8_class_match(cls, s + pos, len - pos);
+        if (m) {
+            if (mlen) {
+                *mlen = m;
+            }
+            return pos;
+        }
+        clen = utf8nclen(s + pos, len - pos, &illlen);
+        pos += clen ? clen : illlen;
+    }
+    return len;
+}
+
+#endif
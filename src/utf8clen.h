@@ -164,4 +164,224 @@ static inline size_t utf8clen(const unsigned char *s, size_t *illlen)
 #undef count_illegal_sequences
 }
 
+/**
+ * @brief Determine the length of a single UTF-8 character in a sized buffer
+ *
+ * This function behaves exactly like utf8clen() but never reads beyond
+ * s[n - 1]. The end of the buffer is treated in the same way as the
+ * terminating NUL character of utf8clen(), so a sequence that is cut off by
+ * the end of the buffer is reported as illegal.
+ *
+ * @param s Pointer to a buffer containing a UTF-8 character
+ * @param n Number of bytes available at s (must be greater than 0)
+ * @param illlen Pointer to a size_t that will receive the number of illegal
+ * bytes if an invalid UTF-8 sequence is detected
+ *
+ * @return The length of the UTF-8 character in bytes (1-4) if valid,
+ *         0 if the UTF-8 sequence is invalid (and illlen is set to the number
+ * of illegal bytes), or SIZE_MAX if parameters are invalid (and errno is set to
+ * EINVAL)
+ */
+static inline size_t utf8nclen(const unsigned char *s, size_t n,
+                               size_t *illlen)
+{
+    if (!s || !n || !illlen) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    unsigned char c = *s;
+    // 1 byte: 00-7F (ASCII)
+    if (c <= 0x7F) {
+        return 1;
+    }
+
+#define is_utf8tail(c) (((c) & 0xC0) == 0x80)
+
+#define is_utf8firstb(c)                                                       \
+    (c <= 0x7F ||                /* 00-7F: ASCII */                            \
+     (c >= 0xC2 && c <= 0xDF) || /* C2-DF: 2 byte */                           \
+     (c >= 0xE0 && c <= 0xEF) || /* E0-EF: 3 byte */                           \
+     (c >= 0xF0 && c <= 0xF4))   /* F0-F4: 4 byte */
+
+#define count_illegal_sequences(max)                                           \
+    do {                                                                       \
+        size_t len = 1;                                                        \
+        while (len < n && len < (size_t)max && !is_utf8firstb(s[len])) {       \
+            len++;                                                             \
+        }                                                                      \
+        *illlen = len;                                                         \
+    } while (0)
+
+    // 2 byte: C2-DF 80-BF
+    if (c >= 0xC2 && c <= 0xDF) {
+        if (n >= 2 && is_utf8tail(s[1])) {
+            return 2;
+        }
+        count_illegal_sequences(2);
+        return 0;
+    }
+
+    // 3 byte: E0 A0-BF 80-BF
+    if (c == 0xE0) {
+        if (n >= 3 && s[1] >= 0xA0 && s[1] <= 0xBF && is_utf8tail(s[2])) {
+            return 3;
+        }
+        count_illegal_sequences(3);
+        return 0;
+    }
+
+    // 3 byte: E1-EC 2(80-BF)
+    //         EE-EF 2(80-BF)
+    if ((c >= 0xE1 && c <= 0xEC) || (c >= 0xEE && c <= 0xEF)) {
+        if (n >= 3 && is_utf8tail(s[1]) && is_utf8tail(s[2])) {
+            return 3;
+        }
+        count_illegal_sequences(3);
+        return 0;
+    }
+
+    // 3 byte: ED 80-9F 80-BF
+    if (c == 0xED) {
+        if (n >= 3 && s[1] >= 0x80 && s[1] <= 0x9F && is_utf8tail(s[2])) {
+            return 3;
+        }
+        count_illegal_sequences(3);
+        return 0;
+    }
+
+    // 4 byte: F0 90-BF 2(80-BF)
+    if (c == 0xF0) {
+        if (n >= 4 && s[1] >= 0x90 && s[1] <= 0xBF && is_utf8tail(s[2]) &&
+            is_utf8tail(s[3])) {
+            return 4;
+        }
+        count_illegal_sequences(4);
+        return 0;
+    }
+
+    // 4 byte: F1-F3 3(80-BF)
+    if (c >= 0xF1 && c <= 0xF3) {
+        if (n >= 4 && is_utf8tail(s[1]) && is_utf8tail(s[2]) &&
+            is_utf8tail(s[3])) {
+            return 4;
+        }
+        count_illegal_sequences(4);
+        return 0;
+    }
+
+    // 4 byte: F4 80-8F 2(80-BF)
+    if (c == 0xF4) {
+        if (n >= 4 && s[1] >= 0x80 && s[1] <= 0x8F && is_utf8tail(s[2]) &&
+            is_utf8tail(s[3])) {
+            return 4;
+        }
+        count_illegal_sequences(4);
+        return 0;
+    }
+
+    count_illegal_sequences(SIZE_MAX);
+    return 0;
+
+#undef is_utf8tail
+#undef is_utf8firstb
+#undef count_illegal_sequences
+}
+
+/**
+ * @brief Check whether bytes are the beginning of a character
+ *
+ * @param s Pointer to the bytes
+ * @param n Number of bytes (1-3)
+ *
+ * @return 1 if the bytes are a proper prefix of a valid character, that is,
+ * an illegal byte sequence only because the character is cut off after them
+ */
+static inline int utf8_is_partial(const unsigned char *s, size_t n)
+{
+    // each possible second byte range, followed by continuation bytes
+    static const unsigned char second[] = {0x80, 0x90, 0xA0};
+    unsigned char seq[4]                = {0, 0x80, 0x80, 0x80};
+    size_t illlen                       = 0;
+
+    if (!s || !n || n > 3) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        seq[i] = s[i];
+    }
+    if (n > 1) {
+        return utf8nclen(seq, 4, &illlen) > n;
+    }
+    for (size_t i = 0; i < sizeof(second); i++) {
+        seq[1] = second[i];
+        if (utf8nclen(seq, 4, &illlen) > n) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//
+// Packed results of utf8clen_packed().
+//
+// The number of bytes to advance is in the low 24 bits and the outcome in
+// the high bits, so a caller can advance with a single mask and check the
+// outcome of a whole batch of characters at once:
+//
+//  uint32_t all = 0;
+//  while (p < end) {
+//      uint32_t r = utf8clen_packed(p, (size_t)(end - p));
+//      all |= r;
+//      p += r & UTF8CLEN_LEN_MASK;
+//  }
+//  if (all & UTF8CLEN_ILLEGAL) { ... }
+//
+#define UTF8CLEN_LEN_MASK  UINT32_C(0x00FFFFFF)
+// the advance covers an illegal byte sequence
+#define UTF8CLEN_ILLEGAL   UINT32_C(0x80000000)
+// the illegal byte sequence is a character cut off by the end of the buffer
+#define UTF8CLEN_TRUNCATED UINT32_C(0x40000000)
+// the parameters are invalid; the advance is 0
+#define UTF8CLEN_EINVAL    UINT32_C(0x20000000)
+
+/**
+ * @brief Determine the length of a single UTF-8 character as a packed value
+ *
+ * This function behaves like utf8nclen(), but returns the outcome and the
+ * number of bytes to advance in a single value instead of through a pointer
+ * and errno. An illegal byte sequence longer than UTF8CLEN_LEN_MASK bytes is
+ * reported as several sequences.
+ *
+ * @param s Pointer to a buffer
+ * @param n Number of bytes in the buffer
+ *
+ * @return The length of the character (1-4), or the length of the illegal
+ * byte sequence with UTF8CLEN_ILLEGAL (and UTF8CLEN_TRUNCATED if it is a
+ * character cut off by the end of the buffer), or UTF8CLEN_EINVAL if s is
+ * NULL or n is 0
+ */
+static inline uint32_t utf8clen_packed(const unsigned char *s, size_t n)
+{
+    size_t illlen = 0;
+    size_t clen   = 0;
+
+    if (!s || !n) {
+        return UTF8CLEN_EINVAL;
+    }
+    // 1 byte: 00-7F (ASCII)
+    if (*s <= 0x7F) {
+        return 1;
+    }
+    clen = utf8nclen(s, n, &illlen);
+    if (clen) {
+        return (uint32_t)clen;
+    } else if (illlen > UTF8CLEN_LEN_MASK) {
+        return UTF8CLEN_ILLEGAL | UTF8CLEN_LEN_MASK;
+    } else if (illlen == n && utf8_is_partial(s, n)) {
+        return UTF8CLEN_ILLEGAL | UTF8CLEN_TRUNCATED | (uint32_t)illlen;
+    }
+    return UTF8CLEN_ILLEGAL | (uint32_t)illlen;
+}
+
 #endif
@@ -0,0 +1,77 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8cmp_h
+#define utf8cmp_h
+
+#include "utf8prefix.h"
+
+/**
+ * @brief Compare two UTF-8 strings in UTF-16 code unit order
+ *
+ * This gives the same order as Java's String.compareTo() and JavaScript's
+ * string comparison without transcoding. The first differing byte is found
+ * with utf8_mismatch(); UTF-8 byte order equals code point order, which only
+ * differs from UTF-16 order in that U+E000-U+FFFF (lead bytes EE-EF) sort
+ * after the supplementary characters (lead bytes F0-F4, surrogate pairs
+ * D800-DFFF in UTF-16). Continuation bytes never take these values, so the
+ * fix-up can be applied to the differing bytes directly.
+ *
+ * @param a Pointer to a UTF-8 string
+ * @param alen Number of bytes in a
+ * @param b Pointer to a UTF-8 string
+ * @param blen Number of bytes in b
+ *
+ * @return A negative value if a sorts before b, 0 if they are equal, or a
+ * positive value if a sorts after b. 0 is also returned if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline int utf8_utf16cmp(const unsigned char *a, size_t alen,
+                                const unsigned char *b, size_t blen)
+{
+    size_t n   = alen < blen ? alen : blen;
+    size_t pos = 0;
+    int ca     = 0;
+    int cb     = 0;
+
+    if ((!a && alen) || (!b && blen)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    pos = utf8_mismatch(a, b, n);
+    if (pos == n) {
+        return alen < blen ? -1 : alen > blen;
+    }
+
+// EE-EF: U+E000-U+FFFF sort after F0-F4: U+10000-U+10FFFF
+#define utf16key(c) ((c) >= 0xEE && (c) <= 0xEF ? (c) + 0x10 : (c))
+
+    ca = utf16key(a[pos]);
+    cb = utf16key(b[pos]);
+    return ca - cb;
+
+#undef utf16key
+}
+
+#endif
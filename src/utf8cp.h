@@ -0,0 +1,112 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8cp_h
+#define utf8cp_h
+
+#include "utf8clen.h"
+
+/**
+ * @brief Decode a single UTF-8 character into a code point
+ *
+ * The character is checked with utf8nclen(), so only well-formed sequences
+ * are decoded.
+ *
+ * @param s Pointer to a buffer containing a UTF-8 character
+ * @param n Number of bytes available at s (must be greater than 0)
+ * @param cp Pointer to a uint32_t that will receive the code point
+ * @param illlen Pointer to a size_t that will receive the number of illegal
+ * bytes if an invalid UTF-8 sequence is detected
+ *
+ * @return The length of the UTF-8 character in bytes (1-4) if valid,
+ *         0 if the UTF-8 sequence is invalid (and illlen is set to the number
+ * of illegal bytes), or SIZE_MAX if parameters are invalid (and errno is set to
+ * EINVAL)
+ */
+static inline size_t utf8_decode(const unsigned char *s, size_t n,
+                                 uint32_t *cp, size_t *illlen)
+{
+    size_t len = 0;
+
+    if (!cp) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    len = utf8nclen(s, n, illlen);
+    switch (len) {
+    case 1:
+        *cp = s[0];
+        break;
+    case 2:
+        *cp = (uint32_t)(s[0] & 0x1F) << 6 | (uint32_t)(s[1] & 0x3F);
+        break;
+    case 3:
+        *cp = (uint32_t)(s[0] & 0x0F) << 12 | (uint32_t)(s[1] & 0x3F) << 6 |
+              (uint32_t)(s[2] & 0x3F);
+        break;
+    case 4:
+        *cp = (uint32_t)(s[0] & 0x07) << 18 | (uint32_t)(s[1] & 0x3F) << 12 |
+              (uint32_t)(s[2] & 0x3F) << 6 | (uint32_t)(s[3] & 0x3F);
+        break;
+    }
+    return len;
+}
+
+/**
+ * @brief Encode a code point as UTF-8
+ *
+ * @param dst Pointer to a buffer of at least 4 bytes
+ * @param cp Code point to encode
+ *
+ * @return The number of bytes written (1-4), or 0 if cp is a surrogate
+ * (U+D800-U+DFFF) or out of the Unicode range (> U+10FFFF)
+ */
+static inline size_t utf8_encode(unsigned char *dst, uint32_t cp)
+{
+    if (cp <= 0x7F) {
+        dst[0] = (unsigned char)cp;
+        return 1;
+    } else if (cp <= 0x7FF) {
+        dst[0] = (unsigned char)(0xC0 | cp >> 6);
+        dst[1] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp <= 0xFFFF) {
+        if (cp >= 0xD800 && cp <= 0xDFFF) {
+            return 0;
+        }
+        dst[0] = (unsigned char)(0xE0 | cp >> 12);
+        dst[1] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+        dst[2] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 3;
+    } else if (cp <= 0x10FFFF) {
+        dst[0] = (unsigned char)(0xF0 | cp >> 18);
+        dst[1] = (unsigned char)(0x80 | (cp >> 12 & 0x3F));
+        dst[2] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+        dst[3] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8csv_h
+#define utf8csv_h
+
+#include "utf8clen.h"
+#include <string.h>
+
+//
+// CSV/TSV row scanner with fused UTF-8 validation.
+//
+// Field boundaries (RFC 4180 quoting) and UTF-8 validity are determined in
+// the same pass: the input is read eight bytes at a time and whole words
+// that contain no delimiter, quote, newline or non-ASCII byte are skipped;
+// only the remaining bytes are inspected one by one, and non-ASCII bytes are
+// checked with utf8nclen().
+//
+
+#define UTF8_CSV_QUOTE '"'
+
+// a byte of x is 00 (may also flag bytes above a 00 byte)
+#define utf8csv_haszero(x)                                                     \
+    (((x) - UINT64_C(0x0101010101010101)) & ~(x) &                             \
+     UINT64_C(0x8080808080808080))
+
+// a byte of x equals c
+#define utf8csv_hasbyte(x, c)                                                  \
+    utf8csv_haszero((x) ^ (UINT64_C(0x0101010101010101) * (c)))
+
+/**
+ * @brief Scan a single row of CSV/TSV data
+ *
+ * A row ends at a newline ("\n" or "\r\n") that is not inside a quoted
+ * field, or at the end of the buffer. The end offset of each field is stored
+ * in fields; field i spans from fields[i - 1] + 1 (or 0) to fields[i] and
+ * still contains its quotes. Only the first maxfields offsets are stored but
+ * nfields receives the actual number of fields.
+ *
+ * @param s Pointer to the data
+ * @param len Number of bytes in the data
+ * @param delim Field delimiter (e.g. ',' or '\t')
+ * @param fields Pointer to an array that will receive the field end offsets
+ * @param maxfields Number of entries of fields
+ * @param nfields Pointer to a size_t that will receive the number of fields
+ * @param illpos Pointer to a size_t that will receive the offset of the first
+ * illegal byte sequence in the row, or SIZE_MAX if the row is valid UTF-8
+ *
+ * @return The number of bytes consumed including the line terminator, or
+ * SIZE_MAX if parameters are invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_csv_row(const unsigned char *s, size_t len,
+                                  unsigned char delim, size_t *fields,
+                                  size_t maxfields, size_t *nfields,
+                                  size_t *illpos)
+{
+    size_t pos    = 0;
+    size_t fstart = 0;
+    size_t nf     = 0;
+    int inquote   = 0;
+
+    if ((!s && len) || (!fields && maxfields) || !nfields || !illpos) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    *illpos = SIZE_MAX;
+    if (!len) {
+        *nfields = 0;
+        return 0;
+    }
+
+#define push_field(end)                                                        \
+    do {                                                                       \
+        if (nf < maxfields) {                                                  \
+            fields[nf] = (end);                                                \
+        }                                                                      \
+        nf++;                                                                  \
+    } while (0)
+
+    while (pos < len) {
+        unsigned char c;
+
+        // skip words without any interesting byte
+        for (; pos + 8 <= len; pos += 8) {
+            uint64_t v;
+            uint64_t m;
+            memcpy(&v, s + pos, 8);
+            m = v & UINT64_C(0x8080808080808080);
+            m |= utf8csv_hasbyte(v, UTF8_CSV_QUOTE);
+            if (!inquote) {
+                m |= utf8csv_hasbyte(v, delim) | utf8csv_hasbyte(v, '\n');
+            }
+            if (m) {
+                break;
+            }
+        }
+        if (pos == len) {
+            break;
+        }
+
+        c = s[pos];
+        if (c >= 0x80) {
+            size_t illlen = 0;
+            size_t clen   = utf8nclen(s + pos, len - pos, &illlen);
+            if (!clen) {
+                if (*illpos == SIZE_MAX) {
+                    *illpos = pos;
+                }
+                clen = illlen;
+            }
+            pos += clen;
+        } else if (c == UTF8_CSV_QUOTE) {
+            if (!inquote) {
+                // a quote only opens a quoted field at its start
+                inquote = pos == fstart;
+            } else if (pos + 1 < len && s[pos + 1] == UTF8_CSV_QUOTE) {
+                // escaped quote
+                pos++;
+            } else {
+                inquote = 0;
+            }
+            pos++;
+        } else if (inquote) {
+            pos++;
+        } else if (c == delim) {
+            push_field(pos);
+            fstart = ++pos;
+        } else if (c == '\n') {
+            push_field(pos > fstart && s[pos - 1] == '\r' ? pos - 1 : pos);
+            *nfields = nf;
+            return pos + 1;
+        } else {
+            pos++;
+        }
+    }
+    push_field(len);
+    *nfields = nf;
+    return len;
+
+#undef push_field
+}
+
+#undef utf8csv_hasbyte
+#undef utf8csv_haszero
+
+#endif
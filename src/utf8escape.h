@@ -0,0 +1,302 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8escape_h
+#define utf8escape_h
+
+#include "utf8sink.h"
+
+//
+// Representations of illegal byte sequences.
+//
+// All representations are built on the illegal byte sequences detected by
+// utf8clen(); valid runs between them are copied as they are.
+//
+//  sanitize:        each illegal byte sequence is replaced with U+FFFD
+//                   ("\xEF\xBF\xBD"). This is lossy.
+//  escape:          each illegal byte is rendered as "\xNN" and each
+//                   backslash is rendered as "\\", so the output is valid
+//                   UTF-8 and the original bytes can always be recovered.
+//  surrogateescape: each illegal byte 80-FF is mapped to U+DC80-U+DCFF
+//                   (PEP 383) and stored as the 3 byte sequence
+//                   ED B2 80 - ED B3 BF. The encoder maps them back.
+//
+// The transforms are implemented on sinks in utf8sink.h; the functions here
+// run them on a fixed sink over dst, which the *_size() functions make
+// large enough.
+//
+
+/**
+ * @brief Compute the exact output size of utf8_sanitize()
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes utf8_sanitize() writes, or SIZE_MAX if
+ * parameters are invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_sanitize_size(const unsigned char *s, size_t len)
+{
+    size_t size = 0;
+    size_t pos  = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    while (pos < len) {
+        size_t vlen   = utf8_validlen(s + pos, len - pos);
+        size_t illlen = 0;
+
+        size += vlen;
+        pos += vlen;
+        if (pos < len) {
+            utf8nclen(s + pos, len - pos, &illlen);
+            size += 3;
+            pos += illlen;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Replace each illegal byte sequence with U+FFFD
+ *
+ * @param dst Pointer to a buffer of at least utf8_sanitize_size(s, len) bytes
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_sanitize(unsigned char *dst, const unsigned char *s,
+                                   size_t len)
+{
+    utf8_sink_t sink;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    // dst is large enough for the whole output, so the sink never fills up
+    utf8_sink_fixed(&sink, dst, SIZE_MAX);
+    return utf8_sanitize_sink(&sink, s, len);
+}
+
+/**
+ * @brief Compute the exact output size of utf8_escape()
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes utf8_escape() writes, or SIZE_MAX if parameters
+ * are invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_escape_size(const unsigned char *s, size_t len)
+{
+    size_t size = len;
+    size_t pos  = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    while (pos < len) {
+        size_t vlen               = utf8_validlen(s + pos, len - pos);
+        const unsigned char *end  = s + pos + vlen;
+        const unsigned char *from = s + pos;
+        size_t illlen             = 0;
+
+        // each backslash is doubled
+        while ((from = memchr(from, '\\', (size_t)(end - from)))) {
+            size++;
+            from++;
+        }
+        pos += vlen;
+        if (pos < len) {
+            // each illegal byte grows from 1 to 4 bytes
+            utf8nclen(s + pos, len - pos, &illlen);
+            size += illlen * 3;
+            pos += illlen;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Escape illegal bytes as "\xNN" and backslashes as "\\"
+ *
+ * @param dst Pointer to a buffer of at least utf8_escape_size(s, len) bytes
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_escape(unsigned char *dst, const unsigned char *s,
+                                 size_t len)
+{
+    utf8_sink_t sink;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    // dst is large enough for the whole output, so the sink never fills up
+    utf8_sink_fixed(&sink, dst, SIZE_MAX);
+    return utf8_escape_sink(&sink, s, len);
+}
+
+/**
+ * @brief Compute the exact output size of utf8_surrogateescape_decode()
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes utf8_surrogateescape_decode() writes, or
+ * SIZE_MAX if parameters are invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_surrogateescape_decode_size(const unsigned char *s,
+                                                      size_t len)
+{
+    size_t size = len;
+    size_t pos  = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    while (pos < len) {
+        size_t illlen = 0;
+
+        pos += utf8_validlen(s + pos, len - pos);
+        if (pos < len) {
+            // each illegal byte grows from 1 to 3 bytes
+            utf8nclen(s + pos, len - pos, &illlen);
+            size += illlen * 2;
+            pos += illlen;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Map illegal bytes to U+DC80-U+DCFF (PEP 383 surrogateescape)
+ *
+ * Each illegal byte B is written as the 3 byte sequence of the code point
+ * U+DC00 + B. Note that the output is not well-formed UTF-8 unless the input
+ * was valid.
+ *
+ * @param dst Pointer to a buffer of at least
+ * utf8_surrogateescape_decode_size(s, len) bytes
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_surrogateescape_decode(unsigned char *dst,
+                                                 const unsigned char *s,
+                                                 size_t len)
+{
+    utf8_sink_t sink;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    // dst is large enough for the whole output, so the sink never fills up
+    utf8_sink_fixed(&sink, dst, SIZE_MAX);
+    return utf8_surrogateescape_decode_sink(&sink, s, len);
+}
+
+/**
+ * @brief Compute the exact output size of utf8_surrogateescape_encode()
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes utf8_surrogateescape_encode() writes, or
+ * SIZE_MAX if parameters are invalid (and errno is set to EINVAL) or if the
+ * buffer contains an illegal byte sequence that is not an escaped byte (and
+ * errno is set to EILSEQ)
+ */
+static inline size_t utf8_surrogateescape_encode_size(const unsigned char *s,
+                                                      size_t len)
+{
+    size_t size = len;
+    size_t pos  = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    while (pos < len) {
+        pos += utf8_validlen(s + pos, len - pos);
+        if (pos < len) {
+            if (!utf8_is_surrogateescape(s + pos, len - pos)) {
+                errno = EILSEQ;
+                return SIZE_MAX;
+            }
+            // each escaped byte shrinks from 3 to 1 byte
+            size -= 2;
+            pos += 3;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Map U+DC80-U+DCFF back to the original bytes 80-FF
+ *
+ * This is the inverse of utf8_surrogateescape_decode().
+ *
+ * @param dst Pointer to a buffer of at least
+ * utf8_surrogateescape_encode_size(s, len) bytes
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL) or if the buffer contains an illegal
+ * byte sequence that is not an escaped byte (and errno is set to EILSEQ)
+ */
+static inline size_t utf8_surrogateescape_encode(unsigned char *dst,
+                                                 const unsigned char *s,
+                                                 size_t len)
+{
+    utf8_sink_t sink;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    // dst is large enough for the whole output, so the sink never fills up
+    utf8_sink_fixed(&sink, dst, SIZE_MAX);
+    return utf8_surrogateescape_encode_sink(&sink, s, len);
+}
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8fixed_h
+#define utf8fixed_h
+
+#include "utf8valid.h"
+
+//
+// Validation of fixed-width, NUL-padded keys.
+//
+// A key is the bytes of a fixed-width field up to the first NUL, or all of
+// them if there is no NUL, which is what a utf8clen() loop over the field
+// accepts. The bytes after the first NUL are not examined.
+//
+// The width is a compile-time constant, so the field is read as a fixed
+// number of 64-bit words without a loop or tail handling after inlining:
+// a key that is all ASCII is accepted by a single test of the OR of the
+// words. UTF8_FIXED_DEFINE() generates the functions for a width (a
+// multiple of 8 from 8 to 64); the widths 8, 16, 32 and 64 are predefined:
+//
+//  size_t utf8_fixed_len16(const unsigned char *s);  // length of the key
+//  int utf8_fixed_valid16(const unsigned char *s);   // 1 if it is valid
+//
+
+/**
+ * @brief Find the length of a key in a fixed-width field
+ *
+ * @param s Pointer to the field
+ * @param width Width of the field, a multiple of 8
+ *
+ * @return The offset of the first NUL, or width if there is none
+ */
+static inline size_t utf8_fixed_len(const unsigned char *s, size_t width)
+{
+    const uint64_t lo7 = UINT64_C(0x7F7F7F7F7F7F7F7F);
+
+    for (size_t pos = 0; pos < width; pos += 8) {
+        uint64_t v;
+        memcpy(&v, s + pos, 8);
+        // only the high bit of each byte that is 00 (exact, no carries)
+        v = ~(((v & lo7) + lo7) | v | lo7);
+        if (v) {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) &&                           \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return pos + (size_t)__builtin_ctzll(v) / 8;
+#else
+            while (s[pos]) {
+                pos++;
+            }
+            return pos;
+#endif
+        }
+    }
+    return width;
+}
+
+/**
+ * @brief Validate the key in a fixed-width field
+ *
+ * @param s Pointer to the field
+ * @param width Width of the field, a multiple of 8 from 8 to 64
+ *
+ * @return 1 if the key is valid, or 0 if it contains an illegal byte sequence
+ */
+static inline int utf8_fixed_valid(const unsigned char *s, size_t width)
+{
+    uint64_t high = 0;
+    size_t len    = 0;
+
+    // unrolled by hand, since compilers do not unroll loops at -O2; the
+    // conditions are constant once width is
+#define or_word(pos)                                                           \
+    do {                                                                       \
+        uint64_t v;                                                            \
+        memcpy(&v, s + (pos), 8);                                              \
+        high |= v;                                                             \
+    } while (0)
+
+    or_word(0);
+    if (width > 8) {
+        or_word(8);
+    }
+    if (width > 16) {
+        or_word(16);
+    }
+    if (width > 24) {
+        or_word(24);
+    }
+    if (width > 32) {
+        or_word(32);
+    }
+    if (width > 40) {
+        or_word(40);
+    }
+    if (width > 48) {
+        or_word(48);
+    }
+    if (width > 56) {
+        or_word(56);
+    }
+
+#undef or_word
+
+    // all ASCII, NUL padding included
+    if (!(high & UINT64_C(0x8080808080808080))) {
+        return 1;
+    }
+    len = utf8_fixed_len(s, width);
+    return utf8_validlen(s, len) == len;
+}
+
+#define UTF8_FIXED_DEFINE(width)                                               \
+    static inline size_t utf8_fixed_len##width(const unsigned char *s)        \
+    {                                                                          \
+        return utf8_fixed_len(s, width);                                       \
+    }                                                                          \
+    static inline int utf8_fixed_valid##width(const unsigned char *s)         \
+    {                                                                          \
+        return utf8_fixed_valid(s, width);                                     \
+    }
+
+UTF8_FIXED_DEFINE(8)
+UTF8_FIXED_DEFINE(16)
+UTF8_FIXED_DEFINE(32)
+UTF8_FIXED_DEFINE(64)
+
+#endif
@@ -0,0 +1,344 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8glob_h
+#define utf8glob_h
+
+#include "utf8class.h"
+
+//
+// Shell-style globs that match whole characters.
+//
+//  ?      matches one character
+//  *      matches any number of characters
+//  [...]  matches one character of a set of characters and ranges of
+//         code points, e.g. [a-z], [α-ω] or [ぁ-ゖ]; [!...] and [^...]
+//         match one character that is not in the set. A ']' right after
+//         the '[' (or the '!' or '^') is part of the set, and a '['
+//         without a closing ']' is a literal '['.
+//  \c     matches c literally
+//
+// Characters are stepped as utf8clen() splits the input: an illegal byte
+// sequence is one character, which '?', '*' and negated sets match, but
+// which no literal and no set contains. Patterns must be valid UTF-8.
+//
+// A pattern is compiled once into literal runs, wildcards and sets, each
+// set into a byte automaton (utf8class.h). Matching checks a literal
+// prefix and suffix with memcmp() first, and only the part between them
+// is matched with backtracking on the last '*'.
+//
+// With UTF8_GLOB_PATHNAME, '/' is only matched by a '/' in the pattern.
+//
+
+#define UTF8_GLOB_PATHNAME 0x1
+
+#define UTF8_GLOB_LITERAL 0
+#define UTF8_GLOB_ANY     1
+#define UTF8_GLOB_STAR    2
+#define UTF8_GLOB_SET     3
+
+typedef struct {
+    int type;
+    // literal bytes in lit
+    size_t off;
+    size_t len;
+    // set, and whether it is negated
+    utf8_class_t *set;
+    int neg;
+} utf8_glob_tok_t;
+
+typedef struct {
+    utf8_glob_tok_t *toks;
+    size_t ntok;
+    unsigned char *lit;
+    int flags;
+    // lengths of the literal prefix and suffix, checked first
+    size_t prefix;
+    size_t suffix;
+} utf8_glob_t;
+
+/**
+ * @brief Free a compiled pattern
+ */
+static inline void utf8_glob_free(utf8_glob_t *g)
+{
+    if (g) {
+        for (size_t i = 0; i < g->ntok; i++) {
+            utf8_class_free(g->toks[i].set);
+        }
+        free(g->toks);
+        free(g->lit);
+        free(g);
+    }
+}
+
+/**
+ * @brief Parse a bracket expression starting after the '['
+ *
+ * @param tok Pointer to the token that receives the set
+ *
+ * @return The offset after the ']', or 0 if there is no ']' (and the '['
+ * is a literal), or SIZE_MAX if out of memory (and errno is set)
+ */
+static inline size_t utf8_glob_set(utf8_glob_tok_t *tok,
+                                   const unsigned char *pat, size_t len,
+                                   size_t pos)
+{
+    utf8_cprange_t *ranges = NULL;
+    size_t nrange          = 0;
+    size_t start           = 0;
+
+    tok->neg = pos < len && (pat[pos] == '!' || pat[pos] == '^');
+    pos += (size_t)tok->neg;
+    start = pos;
+
+    // there can not be more ranges than characters
+    ranges = malloc((len - pos + 1) * sizeof(*ranges));
+    if (!ranges) {
+        errno = ENOMEM;
+        return SIZE_MAX;
+    }
+    while (pos < len && (pat[pos] != ']' || pos == start)) {
+        uint32_t lo   = 0;
+        uint32_t hi   = 0;
+        size_t illlen = 0;
+
+        pos += pat[pos] == '\\' && pos + 1 < len;
+        pos += utf8_decode(pat + pos, len - pos, &lo, &illlen);
+        hi = lo;
+        if (pos + 1 < len && pat[pos] == '-' && pat[pos + 1] != ']') {
+            pos++;
+            pos += pat[pos] == '\\' && pos + 1 < len;
+            pos += utf8_decode(pat + pos, len - pos, &hi, &illlen);
+        }
+        // a reversed range is empty
+        if (lo <= hi) {
+            ranges[nrange++] = (utf8_cprange_t){lo, hi};
+        }
+    }
+    if (pos == len) {
+        free(ranges);
+        return 0;
+    }
+    tok->type = UTF8_GLOB_SET;
+    tok->set  = utf8_class_compile(ranges, nrange);
+    free(ranges);
+    return tok->set ? pos + 1 : SIZE_MAX;
+}
+
+/**
+ * @brief Compile a pattern
+ *
+ * @param pat Pointer to the pattern
+ * @param len Number of bytes in the pattern
+ * @param flags 0 or UTF8_GLOB_PATHNAME
+ *
+ * @return Pointer to the compiled pattern, to be freed with
+ * utf8_glob_free(), or NULL if parameters are invalid (and errno is set to
+ * EINVAL), the pattern is not valid UTF-8 (and errno is set to EILSEQ), or
+ * out of memory (and errno is set to ENOMEM)
+ */
+static inline utf8_glob_t *utf8_glob_compile(const unsigned char *pat,
+                                             size_t len, int flags)
+{
+    utf8_glob_t *g = NULL;
+    size_t pos     = 0;
+    size_t nlit    = 0;
+
+    if (!pat && len) {
+        errno = EINVAL;
+        return NULL;
+    } else if (utf8_validlen(pat, len) != len) {
+        errno = EILSEQ;
+        return NULL;
+    }
+    g = calloc(1, sizeof(*g));
+    if (g) {
+        g->flags = flags;
+        // at most one token per byte
+        g->toks = calloc(len + 1, sizeof(*g->toks));
+        g->lit  = malloc(len + 1);
+    }
+    if (!g || !g->toks || !g->lit) {
+        utf8_glob_free(g);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    while (pos < len) {
+        utf8_glob_tok_t *tok = &g->toks[g->ntok];
+        size_t end           = 0;
+
+        if (pat[pos] == '*') {
+            // consecutive stars are one star
+            if (!g->ntok || tok[-1].type != UTF8_GLOB_STAR) {
+                tok->type = UTF8_GLOB_STAR;
+                g->ntok++;
+            }
+            pos++;
+            continue;
+        } else if (pat[pos] == '?') {
+            tok->type = UTF8_GLOB_ANY;
+            g->ntok++;
+            pos++;
+            continue;
+        } else if (pat[pos] == '[') {
+            end = utf8_glob_set(tok, pat, len, pos + 1);
+            if (end == SIZE_MAX) {
+                utf8_glob_free(g);
+                errno = ENOMEM;
+                return NULL;
+            } else if (end) {
+                g->ntok++;
+                pos = end;
+                continue;
+            }
+        }
+
+        // a literal byte, appended to the previous literal run
+        pos += pat[pos] == '\\' && pos + 1 < len;
+        if (!g->ntok || tok[-1].type != UTF8_GLOB_LITERAL) {
+            *tok = (utf8_glob_tok_t){.type = UTF8_GLOB_LITERAL, .off = nlit};
+            g->ntok++;
+            tok++;
+        }
+        tok[-1].len++;
+        g->lit[nlit++] = pat[pos++];
+    }
+
+    if (g->ntok && g->toks[0].type == UTF8_GLOB_LITERAL) {
+        g->prefix = g->toks[0].len;
+    }
+    if (g->ntok > 1 && g->toks[g->ntok - 1].type == UTF8_GLOB_LITERAL) {
+        g->suffix = g->toks[g->ntok - 1].len;
+    }
+    return g;
+}
+
+/**
+ * @brief Get the length of the character at s, as utf8clen() splits it
+ */
+static inline size_t utf8_glob_step(const unsigned char *s, size_t len)
+{
+    size_t illlen = 0;
+    size_t clen   = 0;
+
+    if (s[0] <= 0x7F) {
+        return 1;
+    }
+    clen = utf8nclen(s, len, &illlen);
+    return clen ? clen : illlen;
+}
+
+/**
+ * @brief Match a string against a compiled pattern
+ *
+ * @param g Pointer to the compiled pattern
+ * @param s Pointer to the string
+ * @param len Number of bytes in the string
+ *
+ * @return 1 if the whole string matches, 0 if not, or -1 if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline int utf8_glob_match(const utf8_glob_t *g,
+                                  const unsigned char *s, size_t len)
+{
+    int pathname = g && g->flags & UTF8_GLOB_PATHNAME;
+    size_t first = 0;
+    size_t last  = 0;
+    size_t ti    = 0;
+    size_t si    = 0;
+    size_t star  = SIZE_MAX;
+    size_t retry = 0;
+
+    if (!g || (!s && len)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!len) {
+        s = (const unsigned char *)"";
+    }
+    if (!g->ntok) {
+        return len == 0;
+    } else if (g->ntok == 1 && g->toks[0].type == UTF8_GLOB_LITERAL) {
+        return len == g->prefix && memcmp(s, g->lit, len) == 0;
+    }
+
+    // the literal prefix and suffix, then the tokens between them
+    if (g->prefix + g->suffix > len ||
+        memcmp(s, g->lit, g->prefix) != 0 ||
+        memcmp(s + len - g->suffix, g->lit + g->toks[g->ntok - 1].off,
+               g->suffix) != 0) {
+        return 0;
+    }
+    first = g->prefix ? 1 : 0;
+    last  = g->ntok - (g->suffix ? 1 : 0);
+    si    = g->prefix;
+    len -= g->suffix;
+
+    ti = first;
+    while (ti < last || si < len) {
+        if (ti < last) {
+            const utf8_glob_tok_t *tok = &g->toks[ti];
+            size_t n                   = 0;
+
+            switch (tok->type) {
+            case UTF8_GLOB_STAR:
+                star  = ti++;
+                retry = si;
+                continue;
+            case UTF8_GLOB_LITERAL:
+                if (len - si >= tok->len &&
+                    memcmp(s + si, g->lit + tok->off, tok->len) == 0) {
+                    si += tok->len;
+                    ti++;
+                    continue;
+                }
+                break;
+            default:
+                if (si == len || (pathname && s[si] == '/')) {
+                    break;
+                }
+                n = utf8_glob_step(s + si, len - si);
+                if (tok->type == UTF8_GLOB_SET &&
+                    (utf8_class_match(tok->set, s + si, n) != 0) == tok->neg) {
+                    break;
+                }
+                si += n;
+                ti++;
+                continue;
+            }
+        }
+        // let the last star take one more character, and retry after it
+        if (star == SIZE_MAX || retry == len ||
+            (pathname && s[retry] == '/')) {
+            return 0;
+        }
+        retry += utf8_glob_step(s + retry, len - retry);
+        si = retry;
+        ti = star + 1;
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,449 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8idna_h
+#define utf8idna_h
+
+#include "utf8cp.h"
+#include "utf8valid.h"
+
+//
+// IDNA ToASCII/ToUnicode conversion of hostnames (RFC 3490/5891) using the
+// Punycode algorithm (RFC 3492).
+//
+// Each label is validated, decoded and encoded in a single pass without
+// allocation; code points are held in a fixed array because a label can not
+// have more than UTF8_IDNA_LABEL_MAX characters in either form. Labels that
+// are ASCII only (the vast majority) are copied as they are.
+//
+// Only the Punycode conversion is performed; the UTS #46 mapping (case
+// folding, normalization) is left to the caller.
+//
+// All functions return SIZE_MAX and set errno on failure:
+//  EINVAL:   parameters are invalid
+//  EILSEQ:   the input is not valid UTF-8 or not valid Punycode
+//  EMSGSIZE: a label is longer than UTF8_IDNA_LABEL_MAX
+//  ERANGE:   the output does not fit in dst
+//
+
+#define UTF8_IDNA_LABEL_MAX 63
+
+// Punycode parameters (RFC 3492 section 5)
+#define UTF8_PUNYCODE_BASE         36
+#define UTF8_PUNYCODE_TMIN         1
+#define UTF8_PUNYCODE_TMAX         26
+#define UTF8_PUNYCODE_SKEW         38
+#define UTF8_PUNYCODE_DAMP         700
+#define UTF8_PUNYCODE_INITIAL_BIAS 72
+#define UTF8_PUNYCODE_INITIAL_N    0x80
+
+/**
+ * @brief Bias adaptation function (RFC 3492 section 6.1)
+ */
+static inline uint32_t utf8_punycode_adapt(uint32_t delta, uint32_t npoints,
+                                           int firsttime)
+{
+    uint32_t k = 0;
+
+    delta = firsttime ? delta / UTF8_PUNYCODE_DAMP : delta / 2;
+    delta += delta / npoints;
+    while (delta > ((UTF8_PUNYCODE_BASE - UTF8_PUNYCODE_TMIN) *
+                    UTF8_PUNYCODE_TMAX) /
+                       2) {
+        delta /= UTF8_PUNYCODE_BASE - UTF8_PUNYCODE_TMIN;
+        k += UTF8_PUNYCODE_BASE;
+    }
+    return k + (UTF8_PUNYCODE_BASE - UTF8_PUNYCODE_TMIN + 1) * delta /
+                   (delta + UTF8_PUNYCODE_SKEW);
+}
+
+/**
+ * @brief Threshold for the digit at position k (RFC 3492 section 6.2)
+ */
+static inline uint32_t utf8_punycode_threshold(uint32_t k, uint32_t bias)
+{
+    if (k <= bias) {
+        return UTF8_PUNYCODE_TMIN;
+    } else if (k >= bias + UTF8_PUNYCODE_TMAX) {
+        return UTF8_PUNYCODE_TMAX;
+    }
+    return k - bias;
+}
+
+#define is_utf8acepfx(s, len)                                                  \
+    ((len) >= 4 && ((s)[0] | 0x20) == 'x' && ((s)[1] | 0x20) == 'n' &&        \
+     (s)[2] == '-' && (s)[3] == '-')
+
+/**
+ * @brief Convert a single label to its ASCII form
+ *
+ * @param dst Pointer to the output buffer
+ * @param dstlen Number of bytes available at dst
+ * @param s Pointer to a UTF-8 label
+ * @param len Number of bytes in the label
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX on failure (and
+ * errno is set)
+ */
+static inline size_t utf8_idna_label_to_ascii(unsigned char *dst,
+                                              size_t dstlen,
+                                              const unsigned char *s,
+                                              size_t len)
+{
+    uint32_t cps[UTF8_IDNA_LABEL_MAX];
+    unsigned char out[UTF8_IDNA_LABEL_MAX];
+    uint32_t ncp   = 0;
+    uint32_t nbase = 0;
+    uint32_t h     = 0;
+    uint32_t n     = UTF8_PUNYCODE_INITIAL_N;
+    uint32_t delta = 0;
+    uint32_t bias  = UTF8_PUNYCODE_INITIAL_BIAS;
+    size_t olen    = 0;
+    size_t pos     = 0;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    // fast path: ASCII only label
+    if (utf8_asciilen(s, len) == len) {
+        if (len > UTF8_IDNA_LABEL_MAX) {
+            errno = EMSGSIZE;
+            return SIZE_MAX;
+        } else if (len > dstlen) {
+            errno = ERANGE;
+            return SIZE_MAX;
+        }
+        memcpy(dst, s, len);
+        return len;
+    }
+
+#define push_output(c)                                                         \
+    do {                                                                       \
+        if (olen == UTF8_IDNA_LABEL_MAX) {                                     \
+            errno = EMSGSIZE;                                                  \
+            return SIZE_MAX;                                                   \
+        }                                                                      \
+        out[olen++] = (unsigned char)(c);                                      \
+    } while (0)
+
+#define push_digit(d) push_output((d) < 26 ? 'a' + (d) : '0' + (d) - 26)
+
+    // validate and decode
+    memcpy(out, "xn--", 4);
+    olen = 4;
+    while (pos < len) {
+        size_t illlen = 0;
+        size_t clen   = 0;
+
+        if (ncp == UTF8_IDNA_LABEL_MAX) {
+            errno = EMSGSIZE;
+            return SIZE_MAX;
+        }
+        clen = utf8_decode(s + pos, len - pos, &cps[ncp], &illlen);
+        if (!clen) {
+            errno = EILSEQ;
+            return SIZE_MAX;
+        }
+        if (cps[ncp] < 0x80) {
+            push_output(cps[ncp]);
+            nbase++;
+        }
+        ncp++;
+        pos += clen;
+    }
+
+    // encode (RFC 3492 section 6.3)
+    h = nbase;
+    if (nbase) {
+        push_output('-');
+    }
+    while (h < ncp) {
+        uint32_t m = UINT32_MAX;
+
+        for (uint32_t i = 0; i < ncp; i++) {
+            if (cps[i] >= n && cps[i] < m) {
+                m = cps[i];
+            }
+        }
+        // at most UTF8_IDNA_LABEL_MAX * 0x10FFFF, so this never overflows
+        delta += (m - n) * (h + 1);
+        n = m;
+        for (uint32_t i = 0; i < ncp; i++) {
+            if (cps[i] < n) {
+                delta++;
+            } else if (cps[i] == n) {
+                uint32_t q = delta;
+
+                for (uint32_t k = UTF8_PUNYCODE_BASE;; k += UTF8_PUNYCODE_BASE) {
+                    uint32_t t = utf8_punycode_threshold(k, bias);
+                    if (q < t) {
+                        break;
+                    }
+                    push_digit(t + (q - t) % (UTF8_PUNYCODE_BASE - t));
+                    q = (q - t) / (UTF8_PUNYCODE_BASE - t);
+                }
+                push_digit(q);
+                bias  = utf8_punycode_adapt(delta, h + 1, h == nbase);
+                delta = 0;
+                h++;
+            }
+        }
+        delta++;
+        n++;
+    }
+
+#undef push_digit
+#undef push_output
+
+    if (olen > dstlen) {
+        errno = ERANGE;
+        return SIZE_MAX;
+    }
+    memcpy(dst, out, olen);
+    return olen;
+}
+
+/**
+ * @brief Convert a single label to its Unicode form
+ *
+ * Labels without the "xn--" prefix are validated and copied as they are.
+ *
+ * @param dst Pointer to the output buffer
+ * @param dstlen Number of bytes available at dst
+ * @param s Pointer to a label
+ * @param len Number of bytes in the label
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX on failure (and
+ * errno is set)
+ */
+static inline size_t utf8_idna_label_to_unicode(unsigned char *dst,
+                                                size_t dstlen,
+                                                const unsigned char *s,
+                                                size_t len)
+{
+    uint32_t cps[UTF8_IDNA_LABEL_MAX];
+    uint32_t ncp  = 0;
+    uint32_t n    = UTF8_PUNYCODE_INITIAL_N;
+    uint32_t i    = 0;
+    uint32_t bias = UTF8_PUNYCODE_INITIAL_BIAS;
+    size_t pos    = 0;
+    size_t olen   = 0;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    if (!is_utf8acepfx(s, len)) {
+        if (utf8_validlen(s, len) != len) {
+            errno = EILSEQ;
+            return SIZE_MAX;
+        } else if (len > dstlen) {
+            errno = ERANGE;
+            return SIZE_MAX;
+        }
+        memcpy(dst, s, len);
+        return len;
+    } else if (len > UTF8_IDNA_LABEL_MAX) {
+        errno = EMSGSIZE;
+        return SIZE_MAX;
+    }
+    s += 4;
+    len -= 4;
+
+    // basic code points are before the last delimiter
+    for (size_t b = len; b > 0; b--) {
+        if (s[b - 1] == '-') {
+            for (; pos < b - 1; pos++) {
+                if (s[pos] >= 0x80) {
+                    errno = EILSEQ;
+                    return SIZE_MAX;
+                }
+                cps[ncp++] = s[pos];
+            }
+            pos = b;
+            break;
+        }
+    }
+
+    // decode (RFC 3492 section 6.2)
+    while (pos < len) {
+        uint32_t oldi = i;
+        uint32_t w    = 1;
+
+        for (uint32_t k = UTF8_PUNYCODE_BASE;; k += UTF8_PUNYCODE_BASE) {
+            uint32_t digit = 0;
+            uint32_t t     = 0;
+            unsigned char c;
+
+            if (pos == len) {
+                errno = EILSEQ;
+                return SIZE_MAX;
+            }
+            c = s[pos++];
+            if (c >= '0' && c <= '9') {
+                digit = (uint32_t)(c - '0' + 26);
+            } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') {
+                digit = (uint32_t)((c | 0x20) - 'a');
+            } else {
+                errno = EILSEQ;
+                return SIZE_MAX;
+            }
+            // the result must stay within the Unicode range, so any larger
+            // value is rejected before it can overflow
+            if (digit > (0x10FFFF * UTF8_IDNA_LABEL_MAX - i) / w) {
+                errno = EILSEQ;
+                return SIZE_MAX;
+            }
+            i += digit * w;
+            t = utf8_punycode_threshold(k, bias);
+            if (digit < t) {
+                break;
+            }
+            w *= UTF8_PUNYCODE_BASE - t;
+        }
+        if (ncp == UTF8_IDNA_LABEL_MAX) {
+            errno = EMSGSIZE;
+            return SIZE_MAX;
+        }
+        bias = utf8_punycode_adapt(i - oldi, ncp + 1, oldi == 0);
+        n += i / (ncp + 1);
+        i %= ncp + 1;
+        if (n > 0x10FFFF || (n >= 0xD800 && n <= 0xDFFF)) {
+            errno = EILSEQ;
+            return SIZE_MAX;
+        }
+        memmove(cps + i + 1, cps + i, (ncp - i) * sizeof(*cps));
+        cps[i++] = n;
+        ncp++;
+    }
+
+    // encode as UTF-8
+    for (uint32_t j = 0; j < ncp; j++) {
+        unsigned char buf[4];
+        size_t clen = utf8_encode(buf, cps[j]);
+
+        if (olen + clen > dstlen) {
+            errno = ERANGE;
+            return SIZE_MAX;
+        }
+        memcpy(dst + olen, buf, clen);
+        olen += clen;
+    }
+    return olen;
+}
+
+#undef is_utf8acepfx
+
+/**
+ * @brief Convert each label of a hostname
+ */
+static inline size_t utf8_idna_convert(
+    unsigned char *dst, size_t dstlen, const unsigned char *s, size_t len,
+    size_t (*convert)(unsigned char *, size_t, const unsigned char *, size_t))
+{
+    const unsigned char *end = s + len;
+    size_t olen              = 0;
+
+    if (!dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    } else if (!len) {
+        return 0;
+    }
+
+    while (1) {
+        const unsigned char *dot = memchr(s, '.', (size_t)(end - s));
+        const unsigned char *tail = dot ? dot : end;
+        size_t n = convert(dst + olen, dstlen - olen, s, (size_t)(tail - s));
+
+        if (n == SIZE_MAX) {
+            return SIZE_MAX;
+        }
+        olen += n;
+        if (!dot) {
+            return olen;
+        } else if (olen == dstlen) {
+            errno = ERANGE;
+            return SIZE_MAX;
+        }
+        dst[olen++] = '.';
+        s           = dot + 1;
+    }
+}
+
+/**
+ * @brief Convert a hostname to its ASCII form (ToASCII)
+ *
+ * @param dst Pointer to the output buffer
+ * @param dstlen Number of bytes available at dst
+ * @param s Pointer to a UTF-8 hostname
+ * @param len Number of bytes in the hostname
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX on failure (and
+ * errno is set)
+ */
+static inline size_t utf8_idna_to_ascii(unsigned char *dst, size_t dstlen,
+                                        const unsigned char *s, size_t len)
+{
+    // fast path: ASCII only hostname only needs the label lengths checked
+    if (dst && s && len <= dstlen && utf8_asciilen(s, len) == len) {
+        const unsigned char *end = s + len;
+        const unsigned char *p   = s;
+
+        while (1) {
+            const unsigned char *dot = memchr(p, '.', (size_t)(end - p));
+            if ((dot ? dot : end) - p > UTF8_IDNA_LABEL_MAX) {
+                errno = EMSGSIZE;
+                return SIZE_MAX;
+            } else if (!dot) {
+                break;
+            }
+            p = dot + 1;
+        }
+        memcpy(dst, s, len);
+        return len;
+    }
+    return utf8_idna_convert(dst, dstlen, s, len, utf8_idna_label_to_ascii);
+}
+
+/**
+ * @brief Convert a hostname to its Unicode form (ToUnicode)
+ *
+ * @param dst Pointer to the output buffer
+ * @param dstlen Number of bytes available at dst
+ * @param s Pointer to a hostname
+ * @param len Number of bytes in the hostname
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX on failure (and
+ * errno is set)
+ */
+static inline size_t utf8_idna_to_unicode(unsigned char *dst, size_t dstlen,
+                                          const unsigned char *s, size_t len)
+{
+    return utf8_idna_convert(dst, dstlen, s, len, utf8_idna_label_to_unicode);
+}
+
+#endif
@@ -0,0 +1,569 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8index_h
+#define utf8index_h
+
+#include "utf8sub.h"
+#include "utf8valid.h"
+
+//
+// Sidecar index of a large UTF-8 file.
+//
+// The file is divided into chunks of a fixed size, and the validity,
+// character count and newline count of each chunk are recorded together
+// with the state at the chunk boundary. The index is a header followed by an
+// array of chunk records, both of fixed size and without pointers, so it
+// can be written to a file as it is and used directly from mmap(2).
+// Reopening a file is then O(chunks) at most, and character and line
+// offsets are found by a binary search over the chunks followed by a scan
+// of a single chunk.
+//
+// A character (or an illegal byte sequence, which counts as one character)
+// belongs to the chunk in which it starts; the bytes of a sequence that
+// continue into the next chunk are recorded as its skip count.
+//
+// Each chunk record also holds a hash of the chunk content, so that an index
+// can be brought up to date after the file has changed by scanning only the
+// chunks that differ (see utf8_index_update()).
+//
+// The index is stored in the native byte order; an index written on a host
+// with another byte order is rejected as invalid.
+//
+
+#define UTF8_INDEX_MAGIC   UINT32_C(0x58493855) // "U8IX"
+#define UTF8_INDEX_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    // size of each chunk in bytes
+    uint64_t chunk_size;
+    // size of the indexed file
+    uint64_t file_size;
+    // caller-defined key of the file content (e.g. mtime or a checksum)
+    uint64_t key;
+    uint64_t nchunk;
+    // totals of the whole file
+    uint64_t nchar;
+    uint64_t nline;
+    // number of chunks that contain an illegal byte sequence
+    uint64_t ninvalid;
+} utf8_index_header_t;
+
+typedef struct {
+    // hash of the chunk content (see utf8_index_hash())
+    uint64_t hash;
+    // number of characters and newlines before this chunk
+    uint64_t char_offset;
+    uint64_t line_offset;
+    // number of characters and newlines in this chunk
+    uint32_t nchar;
+    uint32_t nline;
+    // offset of the first character that starts in this chunk
+    uint32_t skip;
+    // 1 if no illegal byte sequence starts in this chunk
+    uint32_t valid;
+} utf8_index_chunk_t;
+
+/**
+ * @brief Get the chunk records that follow the header
+ */
+static inline const utf8_index_chunk_t *
+utf8_index_chunks(const utf8_index_header_t *hdr)
+{
+    return (const utf8_index_chunk_t *)(const void *)(hdr + 1);
+}
+
+/**
+ * @brief Compute the size of the index of a file
+ *
+ * @param len Size of the file
+ * @param chunk_size Size of each chunk (1 to UINT32_MAX)
+ *
+ * @return The size of the index in bytes, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_index_size(size_t len, size_t chunk_size)
+{
+    if (!chunk_size || chunk_size > UINT32_MAX) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    return sizeof(utf8_index_header_t) +
+           (len + chunk_size - 1) / chunk_size * sizeof(utf8_index_chunk_t);
+}
+
+/**
+ * @brief Count the newlines in a buffer eight bytes at a time
+ */
+static inline size_t utf8_index_nlcount(const unsigned char *s, size_t len)
+{
+    const uint64_t lo7 = UINT64_C(0x7F7F7F7F7F7F7F7F);
+    size_t n           = 0;
+    size_t pos         = 0;
+
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t v;
+        memcpy(&v, s + pos, 8);
+        v ^= UINT64_C(0x0A0A0A0A0A0A0A0A);
+        // only the high bit of each byte that is 00 (exact, no carries),
+        // which utf8_nlead64() sees as a continuation byte
+        v = ~(((v & lo7) + lo7) | v | lo7);
+        n += 8 - utf8_nlead64(v);
+    }
+    for (; pos < len; pos++) {
+        n += s[pos] == '\n';
+    }
+    return n;
+}
+
+/**
+ * @brief Hash the content of a chunk
+ *
+ * A fast non-cryptographic hash that reads four words per round, used to
+ * find the chunks that have changed since the index was built.
+ */
+static inline uint64_t utf8_index_hash(const unsigned char *s, size_t len)
+{
+    const uint64_t p1 = UINT64_C(0x9E3779B185EBCA87);
+    const uint64_t p2 = UINT64_C(0xC2B2AE3D27D4EB4F);
+    const uint64_t p3 = UINT64_C(0x165667B19E3779F9);
+    uint64_t h        = p3 + (uint64_t)len;
+    size_t pos        = 0;
+    uint64_t v;
+
+#define rotl64(x, r) ((x) << (r) | (x) >> (64 - (r)))
+#define hash_round(acc, pos)                                                   \
+    do {                                                                       \
+        memcpy(&v, s + (pos), 8);                                              \
+        (acc) += v * p2;                                                       \
+        (acc) = rotl64((acc), 31) * p1;                                        \
+    } while (0)
+
+    if (len >= 32) {
+        uint64_t a = p1 + p2;
+        uint64_t b = p2;
+        uint64_t c = 0;
+        uint64_t d = 0 - p1;
+
+        for (; pos + 32 <= len; pos += 32) {
+            hash_round(a, pos);
+            hash_round(b, pos + 8);
+            hash_round(c, pos + 16);
+            hash_round(d, pos + 24);
+        }
+        h += rotl64(a, 1) + rotl64(b, 7) + rotl64(c, 12) + rotl64(d, 18);
+    }
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t acc = 0;
+        hash_round(acc, pos);
+        h = rotl64(h ^ acc, 27) * p1 + p3;
+    }
+    for (; pos < len; pos++) {
+        h = rotl64(h ^ (s[pos] * p3), 11) * p1;
+    }
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    h ^= h >> 32;
+
+#undef hash_round
+#undef rotl64
+
+    return h;
+}
+
+/**
+ * @brief Scan the chunks [from, nchunk) of a file into index records
+ *
+ * Scanning starts at the first character boundary of chunk from, which is
+ * given as its skip count. The hashes of the chunks are not computed.
+ *
+ * @return The skip count of chunk nchunk
+ */
+static inline size_t utf8_index_scan(utf8_index_chunk_t *chunks, size_t from,
+                                   size_t nchunk, size_t skip,
+                                   const unsigned char *s, size_t len,
+                                   size_t chunk_size)
+{
+    uint64_t char_offset = from ? chunks[from - 1].char_offset +
+                                      chunks[from - 1].nchar
+                                : 0;
+    uint64_t line_offset = from ? chunks[from - 1].line_offset +
+                                      chunks[from - 1].nline
+                                : 0;
+    size_t pos           = from * chunk_size + skip;
+
+    for (size_t c = from; c < nchunk; c++) {
+        utf8_index_chunk_t *chunk = &chunks[c];
+        size_t head               = c * chunk_size;
+        size_t tail = len - head < chunk_size ? len : head + chunk_size;
+        uint32_t nchar            = 0;
+        uint32_t valid            = 1;
+
+        // a sequence of the previous chunks may cover this chunk
+        chunk->skip  = (uint32_t)(pos < tail ? pos - head : tail - head);
+        chunk->nline = (uint32_t)utf8_index_nlcount(s + head, tail - head);
+        while (pos < tail) {
+            size_t n      = utf8_asciilen(s + pos, tail - pos);
+            size_t illlen = 0;
+            size_t clen   = 0;
+
+            nchar += (uint32_t)n;
+            pos += n;
+            if (pos == tail) {
+                break;
+            }
+            // the sequence may continue into the next chunk
+            clen = utf8nclen(s + pos, len - pos, &illlen);
+            if (!clen) {
+                valid = 0;
+                clen  = illlen;
+            }
+            nchar++;
+            pos += clen;
+        }
+        chunk->nchar       = nchar;
+        chunk->valid       = valid;
+        chunk->char_offset = char_offset;
+        chunk->line_offset = line_offset;
+        char_offset += nchar;
+        line_offset += chunk->nline;
+    }
+    return pos > nchunk * chunk_size ? pos - nchunk * chunk_size : 0;
+}
+
+/**
+ * @brief Fill the header totals from the chunk records
+ */
+static inline void utf8_index_total(utf8_index_header_t *hdr)
+{
+    const utf8_index_chunk_t *chunks = utf8_index_chunks(hdr);
+
+    hdr->nchar    = 0;
+    hdr->nline    = 0;
+    hdr->ninvalid = 0;
+    if (hdr->nchunk) {
+        const utf8_index_chunk_t *last = &chunks[hdr->nchunk - 1];
+        hdr->nchar                     = last->char_offset + last->nchar;
+        hdr->nline                     = last->line_offset + last->nline;
+    }
+    for (uint64_t c = 0; c < hdr->nchunk; c++) {
+        hdr->ninvalid += !chunks[c].valid;
+    }
+}
+
+/**
+ * @brief Build the index of a file
+ *
+ * @param buf Pointer to a buffer of at least utf8_index_size(len,
+ * chunk_size) bytes, aligned to 8 bytes (e.g. a mapping of the index file)
+ * @param bufsize Number of bytes available at buf
+ * @param s Pointer to the file content
+ * @param len Size of the file
+ * @param chunk_size Size of each chunk (1 to UINT32_MAX)
+ * @param key Caller-defined key of the file content (e.g. mtime or a
+ * checksum)
+ *
+ * @return The number of bytes written to buf, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_index_build(void *buf, size_t bufsize,
+                                      const unsigned char *s, size_t len,
+                                      size_t chunk_size, uint64_t key)
+{
+    utf8_index_header_t *hdr   = buf;
+    utf8_index_chunk_t *chunks = NULL;
+    size_t size                = utf8_index_size(len, chunk_size);
+
+    if (size == SIZE_MAX || !buf || bufsize < size || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    *hdr = (utf8_index_header_t){
+        .magic      = UTF8_INDEX_MAGIC,
+        .version    = UTF8_INDEX_VERSION,
+        .chunk_size = chunk_size,
+        .file_size  = len,
+        .key        = key,
+        .nchunk     = (len + chunk_size - 1) / chunk_size,
+    };
+    chunks = (utf8_index_chunk_t *)(hdr + 1);
+    utf8_index_scan(chunks, 0, (size_t)hdr->nchunk, 0, s, len, chunk_size);
+    for (size_t c = 0; c < hdr->nchunk; c++) {
+        size_t head     = c * chunk_size;
+        chunks[c].hash = utf8_index_hash(
+            s + head, len - head < chunk_size ? len - head : chunk_size);
+    }
+    utf8_index_total(hdr);
+    return size;
+}
+
+/**
+ * @brief Check an index and its key before use
+ *
+ * @param buf Pointer to the index (e.g. a mapping of the index file)
+ * @param bufsize Number of bytes available at buf
+ * @param file_size Current size of the indexed file
+ * @param key Current key of the indexed file
+ *
+ * @return Pointer to the header, or NULL if the index is malformed (and errno
+ * is set to EINVAL) or was built for another file content (and errno is set
+ * to ESTALE)
+ */
+static inline const utf8_index_header_t *
+utf8_index_open(const void *buf, size_t bufsize, uint64_t file_size,
+                uint64_t key)
+{
+    const utf8_index_header_t *hdr = buf;
+
+    if (!buf || bufsize < sizeof(*hdr) || hdr->magic != UTF8_INDEX_MAGIC ||
+        hdr->version != UTF8_INDEX_VERSION || !hdr->chunk_size ||
+        hdr->chunk_size > UINT32_MAX || hdr->file_size > SIZE_MAX ||
+        hdr->nchunk != (hdr->file_size + hdr->chunk_size - 1) /
+                           hdr->chunk_size ||
+        utf8_index_size((size_t)hdr->file_size, (size_t)hdr->chunk_size) >
+            bufsize) {
+        errno = EINVAL;
+        return NULL;
+    } else if (hdr->file_size != file_size || hdr->key != key) {
+        errno = ESTALE;
+        return NULL;
+    }
+    return hdr;
+}
+
+/**
+ * @brief Bring the index of a file up to date after the file has changed
+ *
+ * Every chunk of the new content is hashed and compared with the hash in the
+ * index, and only the chunks whose content has changed are scanned again,
+ * so the cost of scanning is proportional to the amount of change. As a
+ * character may cross chunk boundaries, the scan of a changed region starts
+ * at the last character boundary before it and continues until the boundary
+ * state agrees with the index again. The chunk size of the index is kept.
+ *
+ * @param buf Pointer to an index built by utf8_index_build() (e.g. a mapping
+ * of the index file), with room for utf8_index_size(len, chunk_size) bytes
+ * @param bufsize Number of bytes available at buf
+ * @param s Pointer to the new file content
+ * @param len New size of the file
+ * @param key New key of the file content
+ * @param nscan Pointer to store the number of chunks scanned again, or NULL
+ *
+ * @return The number of bytes of the updated index, or SIZE_MAX if the index
+ * is malformed or parameters are invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_index_update(void *buf, size_t bufsize,
+                                       const unsigned char *s, size_t len,
+                                       uint64_t key, size_t *nscan)
+{
+    utf8_index_header_t *hdr   = buf;
+    utf8_index_chunk_t *chunks = NULL;
+    size_t chunk_size          = 0;
+    size_t size                = 0;
+    size_t nchunk              = 0;
+    size_t oldchunk            = 0;
+    size_t last                = SIZE_MAX;
+    size_t nscanned            = 0;
+    uint64_t char_offset       = 0;
+    uint64_t line_offset       = 0;
+
+    // the index must be intact, but may have been built for another content
+    if (!buf || bufsize < sizeof(*hdr) || (!s && len) ||
+        !utf8_index_open(buf, bufsize, hdr->file_size, hdr->key)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    chunk_size = (size_t)hdr->chunk_size;
+    size       = utf8_index_size(len, chunk_size);
+    if (bufsize < size) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    chunks   = (utf8_index_chunk_t *)(hdr + 1);
+    nchunk   = (len + chunk_size - 1) / chunk_size;
+    oldchunk = (size_t)hdr->nchunk;
+    // the last character of the file may have been cut off or continued
+    if (len != hdr->file_size && nchunk) {
+        last = nchunk - 1;
+    }
+
+#define chunk_len(c)                                                           \
+    (len - (c) * chunk_size < chunk_size ? len - (c) * chunk_size : chunk_size)
+#define chunk_hash(c) utf8_index_hash(s + (c) * chunk_size, chunk_len(c))
+#define is_unchanged(c, h)                                                     \
+    ((c) < oldchunk && (c) != last && chunks[c].hash == (h))
+
+    for (size_t c = 0; c < nchunk;) {
+        uint64_t first_hash = chunk_hash(c);
+        uint64_t h          = 0;
+        size_t from         = c;
+        size_t skip         = 0;
+        size_t first        = c;
+
+        if (is_unchanged(c, first_hash)) {
+            c++;
+            continue;
+        }
+        // go back to the chunk in which the character before the change
+        // starts, skipping chunks that are covered by a single sequence
+        while (from > 0 && chunks[--from].skip >= chunk_size) {
+        }
+        skip = from ? chunks[from].skip : 0;
+        for (c = from; c < nchunk; c++) {
+            if (c > first) {
+                h = chunk_hash(c);
+                // the rest of the chunks agree with the index again
+                if (is_unchanged(c, h) && skip < chunk_len(c) &&
+                    skip == chunks[c].skip) {
+                    c++;
+                    break;
+                }
+            } else {
+                h = c == first ? first_hash : chunks[c].hash;
+            }
+            skip = utf8_index_scan(chunks, c, c + 1, skip, s, len, chunk_size);
+            chunks[c].hash = h;
+            nscanned++;
+        }
+    }
+
+#undef is_unchanged
+#undef chunk_hash
+#undef chunk_len
+
+    // the character and line offsets of the following chunks may have moved
+    for (size_t c = 0; c < nchunk; c++) {
+        chunks[c].char_offset = char_offset;
+        chunks[c].line_offset = line_offset;
+        char_offset += chunks[c].nchar;
+        line_offset += chunks[c].nline;
+    }
+    hdr->file_size = len;
+    hdr->key       = key;
+    hdr->nchunk    = nchunk;
+    utf8_index_total(hdr);
+    if (nscan) {
+        *nscan = nscanned;
+    }
+    return size;
+}
+
+/**
+ * @brief Find the byte offset of a character
+ *
+ * @param hdr Pointer to the header returned by utf8_index_open()
+ * @param s Pointer to the file content
+ * @param idx 0-based index of the character
+ *
+ * @return The byte offset of the character, or the file size if the file has
+ * no more than idx characters
+ */
+static inline size_t utf8_index_seek(const utf8_index_header_t *hdr,
+                                     const unsigned char *s, uint64_t idx)
+{
+    const utf8_index_chunk_t *chunks = utf8_index_chunks(hdr);
+    size_t len                       = (size_t)hdr->file_size;
+    size_t lo                        = 0;
+    size_t hi                        = (size_t)hdr->nchunk;
+    size_t pos                       = 0;
+
+    if (idx >= hdr->nchar) {
+        return len;
+    }
+    // the last chunk that starts at or before idx always contains it
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (chunks[mid].char_offset <= idx) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    idx -= chunks[lo].char_offset;
+    pos = lo * (size_t)hdr->chunk_size + chunks[lo].skip;
+    if (chunks[lo].valid) {
+        // lead bytes are characters in a valid chunk
+        return pos + utf8_offset(s + pos, len - pos, (size_t)idx);
+    }
+    for (; idx; idx--) {
+        size_t illlen = 0;
+        size_t clen   = utf8nclen(s + pos, len - pos, &illlen);
+        pos += clen ? clen : illlen;
+    }
+    return pos;
+}
+
+/**
+ * @brief Find the byte offset of the start of a line
+ *
+ * @param hdr Pointer to the header returned by utf8_index_open()
+ * @param s Pointer to the file content
+ * @param line 0-based line number
+ *
+ * @return The byte offset of the line, or the file size if the file has no
+ * more than line newlines
+ */
+static inline size_t utf8_index_seek_line(const utf8_index_header_t *hdr,
+                                          const unsigned char *s,
+                                          uint64_t line)
+{
+    const utf8_index_chunk_t *chunks = utf8_index_chunks(hdr);
+    size_t len                       = (size_t)hdr->file_size;
+    size_t lo                        = 0;
+    size_t hi                        = (size_t)hdr->nchunk;
+    size_t pos                       = 0;
+
+    if (line == 0) {
+        return 0;
+    } else if (line > hdr->nline) {
+        return len;
+    }
+    // the last chunk that starts before the newline ending line - 1 always
+    // contains it
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (chunks[mid].line_offset < line) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    line -= chunks[lo].line_offset;
+    pos = lo * (size_t)hdr->chunk_size;
+    for (;;) {
+        const unsigned char *nl = memchr(s + pos, '\n', len - pos);
+        pos                     = (size_t)(nl - s) + 1;
+        if (!--line) {
+            return pos;
+        }
+    }
+}
+
+#endif
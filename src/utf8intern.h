@@ -0,0 +1,324 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8intern_h
+#define utf8intern_h
+
+#include "utf8valid.h"
+#include <pthread.h>
+
+//
+// Concurrent string interning table that remembers the validation result of
+// each string.
+//
+// A string is validated only once, when it is inserted; the result is
+// stored in the entry, so later lookups of the same string only hash it.
+// The table is split into shards selected by the hash, each protected by a
+// read-write lock, so lookups from many threads proceed in parallel.
+//
+// Entries are never removed until the table is freed, so the returned
+// pointers stay valid for the lifetime of the table.
+//
+// Requires POSIX threads (compile with -pthread).
+//
+
+#define UTF8_INTERN_VALID 0x1
+#define UTF8_INTERN_ASCII 0x2
+
+typedef struct utf8_intern_entry {
+    struct utf8_intern_entry *next;
+    uint64_t hash;
+    size_t len;
+    unsigned int flags;
+    // NUL-terminated copy of the string
+    unsigned char str[];
+} utf8_intern_entry_t;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    utf8_intern_entry_t **buckets;
+    size_t nbucket;
+    size_t nentry;
+} utf8_intern_shard_t;
+
+typedef struct {
+    size_t nshard;
+    utf8_intern_shard_t shards[];
+} utf8_intern_t;
+
+#define UTF8_INTERN_NBUCKET 16
+
+/**
+ * @brief Hash a string eight bytes at a time
+ */
+static inline uint64_t utf8_intern_hash(const unsigned char *s, size_t len)
+{
+    uint64_t h = UINT64_C(0x9E3779B97F4A7C15) ^ len;
+    uint64_t v = 0;
+    size_t pos = 0;
+
+    for (; pos + 8 <= len; pos += 8) {
+        memcpy(&v, s + pos, 8);
+        h = (h ^ v) * UINT64_C(0xFF51AFD7ED558CCD);
+        h ^= h >> 32;
+    }
+    if (pos < len) {
+        v = 0;
+        memcpy(&v, s + pos, len - pos);
+        h = (h ^ v) * UINT64_C(0xFF51AFD7ED558CCD);
+    }
+
+    // finalizer of MurmurHash3
+    h ^= h >> 33;
+    h *= UINT64_C(0xC4CEB9FE1A85EC53);
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Validate a string and return its UTF8_INTERN_* flags
+ */
+static inline unsigned int utf8_intern_flags(const unsigned char *s,
+                                             size_t len)
+{
+    size_t pos = utf8_asciilen(s, len);
+
+    if (pos == len) {
+        return UTF8_INTERN_VALID | UTF8_INTERN_ASCII;
+    } else if (pos + utf8_validlen(s + pos, len - pos) == len) {
+        return UTF8_INTERN_VALID;
+    }
+    return 0;
+}
+
+/**
+ * @brief Create an intern table
+ *
+ * @param nshard Number of shards, rounded up to a power of two (0 selects a
+ * default of 64)
+ *
+ * @return Pointer to the table, or NULL on failure (and errno is set)
+ */
+static inline utf8_intern_t *utf8_intern_new(size_t nshard)
+{
+    utf8_intern_t *tab = NULL;
+    size_t n           = 1;
+
+    if (!nshard) {
+        nshard = 64;
+    }
+    while (n < nshard) {
+        n <<= 1;
+    }
+
+    tab = calloc(1, sizeof(utf8_intern_t) + n * sizeof(utf8_intern_shard_t));
+    if (!tab) {
+        return NULL;
+    }
+    for (; tab->nshard < n; tab->nshard++) {
+        utf8_intern_shard_t *shard = &tab->shards[tab->nshard];
+        int rc                     = 0;
+
+        shard->buckets = calloc(UTF8_INTERN_NBUCKET, sizeof(*shard->buckets));
+        if (!shard->buckets) {
+            break;
+        } else if ((rc = pthread_rwlock_init(&shard->lock, NULL))) {
+            free(shard->buckets);
+            errno = rc;
+            break;
+        }
+        shard->nbucket = UTF8_INTERN_NBUCKET;
+    }
+    if (tab->nshard < n) {
+        int err = errno;
+        for (size_t i = 0; i < tab->nshard; i++) {
+            pthread_rwlock_destroy(&tab->shards[i].lock);
+            free(tab->shards[i].buckets);
+        }
+        free(tab);
+        errno = err;
+        return NULL;
+    }
+    return tab;
+}
+
+/**
+ * @brief Free an intern table and all of its entries
+ */
+static inline void utf8_intern_free(utf8_intern_t *tab)
+{
+    if (!tab) {
+        return;
+    }
+    for (size_t i = 0; i < tab->nshard; i++) {
+        utf8_intern_shard_t *shard = &tab->shards[i];
+
+        for (size_t b = 0; b < shard->nbucket; b++) {
+            utf8_intern_entry_t *e = shard->buckets[b];
+            while (e) {
+                utf8_intern_entry_t *next = e->next;
+                free(e);
+                e = next;
+            }
+        }
+        pthread_rwlock_destroy(&shard->lock);
+        free(shard->buckets);
+    }
+    free(tab);
+}
+
+// shards use the upper bits of the hash, buckets the lower bits
+#define utf8intern_shard(tab, h)                                               \
+    (&(tab)->shards[(h) >> 32 & ((tab)->nshard - 1)])
+
+static inline utf8_intern_entry_t *
+utf8_intern_search(const utf8_intern_shard_t *shard, uint64_t h,
+                   const unsigned char *s, size_t len)
+{
+    utf8_intern_entry_t *e = shard->buckets[h & (shard->nbucket - 1)];
+
+    for (; e; e = e->next) {
+        if (e->hash == h && e->len == len && memcmp(e->str, s, len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Look up a string without inserting it
+ *
+ * The string is only hashed, never validated.
+ *
+ * @param tab Pointer to the table
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return Pointer to the entry, or NULL if the string is not interned or
+ * parameters are invalid (and errno is set to EINVAL)
+ */
+static inline const utf8_intern_entry_t *
+utf8_intern_find(utf8_intern_t *tab, const unsigned char *s, size_t len)
+{
+    uint64_t h                 = 0;
+    utf8_intern_shard_t *shard = NULL;
+    utf8_intern_entry_t *e     = NULL;
+
+    if (!tab || (!s && len)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    h     = utf8_intern_hash(s, len);
+    shard = utf8intern_shard(tab, h);
+    pthread_rwlock_rdlock(&shard->lock);
+    e = utf8_intern_search(shard, h, s, len);
+    pthread_rwlock_unlock(&shard->lock);
+    return e;
+}
+
+/**
+ * @brief Intern a string
+ *
+ * The string is hashed and looked up; only when it is not interned yet it
+ * is validated, copied and inserted together with its UTF8_INTERN_* flags.
+ *
+ * @param tab Pointer to the table
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return Pointer to the entry, or NULL on failure (and errno is set)
+ */
+static inline const utf8_intern_entry_t *
+utf8_intern(utf8_intern_t *tab, const unsigned char *s, size_t len)
+{
+    uint64_t h                 = 0;
+    utf8_intern_shard_t *shard = NULL;
+    utf8_intern_entry_t *e     = NULL;
+    utf8_intern_entry_t *found = NULL;
+
+    if (!tab || (!s && len)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    h     = utf8_intern_hash(s, len);
+    shard = utf8intern_shard(tab, h);
+    pthread_rwlock_rdlock(&shard->lock);
+    found = utf8_intern_search(shard, h, s, len);
+    pthread_rwlock_unlock(&shard->lock);
+    if (found) {
+        return found;
+    }
+
+    // validate and copy outside of the lock
+    e = malloc(sizeof(utf8_intern_entry_t) + len + 1);
+    if (!e) {
+        return NULL;
+    }
+    e->hash  = h;
+    e->len   = len;
+    e->flags = utf8_intern_flags(s, len);
+    memcpy(e->str, s, len);
+    e->str[len] = 0;
+
+    pthread_rwlock_wrlock(&shard->lock);
+    // another thread may have inserted it in the meantime
+    found = utf8_intern_search(shard, h, s, len);
+    if (found) {
+        pthread_rwlock_unlock(&shard->lock);
+        free(e);
+        return found;
+    }
+
+    // keep the load factor at or below 1
+    if (shard->nentry >= shard->nbucket) {
+        size_t nbucket                = shard->nbucket * 2;
+        utf8_intern_entry_t **buckets = calloc(nbucket, sizeof(*buckets));
+
+        if (buckets) {
+            for (size_t b = 0; b < shard->nbucket; b++) {
+                utf8_intern_entry_t *it = shard->buckets[b];
+                while (it) {
+                    utf8_intern_entry_t *next = it->next;
+                    size_t idx                = it->hash & (nbucket - 1);
+                    it->next                  = buckets[idx];
+                    buckets[idx]              = it;
+                    it                        = next;
+                }
+            }
+            free(shard->buckets);
+            shard->buckets = buckets;
+            shard->nbucket = nbucket;
+        }
+    }
+    e->next = shard->buckets[h & (shard->nbucket - 1)];
+    shard->buckets[h & (shard->nbucket - 1)] = e;
+    shard->nentry++;
+    pthread_rwlock_unlock(&shard->lock);
+    return e;
+}
+
+#undef utf8intern_shard
+
+#endif
@@ -0,0 +1,307 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8lines_h
+#define utf8lines_h
+
+#include "utf8valid.h"
+#include <pthread.h>
+#include <unistd.h>
+
+//
+// Line-oriented validation for NDJSON and log files.
+//
+// '\n' can never be part of a character or of an illegal byte sequence, so
+// every line can be validated on its own and a buffer can be divided
+// between threads at any newline. The result lists each line that contains
+// an illegal byte sequence, with the offset of its first one, and a bitmap
+// with one bit per line.
+//
+// Newlines are counted in the same pass as the validation: words of 8 ASCII
+// bytes are checked for '\n' with a zero-byte test and counted with a
+// popcount, and other bytes are checked with utf8nclen(). After the first
+// illegal byte sequence of a line, the rest of the line is skipped with
+// memchr().
+//
+// Lines are numbered from 0. A last line without a newline counts as a
+// line.
+//
+// Requires POSIX threads (compile with -pthread).
+//
+
+#define UTF8_LINES_MAXTHREAD 256
+
+typedef struct {
+    size_t line;
+    // offset of the first illegal byte sequence of the line
+    size_t offset;
+} utf8_badline_t;
+
+typedef struct {
+    size_t nline;
+    size_t nbad;
+    // bad lines in ascending order
+    utf8_badline_t *bad;
+    // bit line % 64 of word line / 64 is set for each bad line
+    uint64_t *bitmap;
+} utf8_lines_t;
+
+typedef struct {
+    const unsigned char *s;
+    size_t start;
+    size_t end;
+    size_t nnewline;
+    utf8_badline_t *bad;
+    size_t nbad;
+    size_t cap;
+    int nomem;
+    int started;
+    pthread_t thread;
+} utf8_lines_stripe_t;
+
+/**
+ * @brief Count the bytes with the high bit set in a 64-bit word
+ */
+static inline size_t utf8_lines_count64(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_popcountll(v);
+#else
+    v >>= 7;
+    return (size_t)((v * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/**
+ * @brief Record a bad line of a stripe
+ */
+static inline void utf8_lines_add(utf8_lines_stripe_t *st, size_t line,
+                                  size_t offset)
+{
+    if (st->nbad == st->cap) {
+        size_t cap           = st->cap ? st->cap * 2 : 16;
+        utf8_badline_t *bad = realloc(st->bad, cap * sizeof(*bad));
+
+        if (!bad) {
+            st->nomem = 1;
+            return;
+        }
+        st->bad = bad;
+        st->cap = cap;
+    }
+    st->bad[st->nbad++] = (utf8_badline_t){.line = line, .offset = offset};
+}
+
+/**
+ * @brief Count the newlines and find the bad lines of a stripe
+ *
+ * Line numbers are relative to the start of the stripe.
+ */
+static inline void *utf8_lines_scan(void *arg)
+{
+    const uint64_t lo7     = UINT64_C(0x7F7F7F7F7F7F7F7F);
+    const uint64_t hi      = UINT64_C(0x8080808080808080);
+    const uint64_t nl      = UINT64_C(0x0A0A0A0A0A0A0A0A);
+    utf8_lines_stripe_t *st = arg;
+    const unsigned char *s = st->s;
+    size_t end             = st->end;
+    size_t pos             = st->start;
+    size_t line            = 0;
+
+    while (pos < end) {
+        const unsigned char *next = NULL;
+        size_t illlen             = 0;
+        size_t clen               = 0;
+
+        for (; pos + 8 <= end; pos += 8) {
+            uint64_t v;
+            uint64_t x;
+
+            memcpy(&v, s + pos, 8);
+            if (v & hi) {
+                break;
+            }
+            // high bit of each byte that is '\n'
+            x = v ^ nl;
+            line += utf8_lines_count64(~(((x & lo7) + lo7) | x | lo7));
+        }
+        if (pos == end) {
+            break;
+        } else if (s[pos] < 0x80) {
+            line += s[pos] == '\n';
+            pos++;
+            continue;
+        }
+
+        clen = utf8nclen(s + pos, end - pos, &illlen);
+        if (clen) {
+            pos += clen;
+            continue;
+        }
+        utf8_lines_add(st, line, pos);
+        pos += illlen;
+        next = memchr(s + pos, '\n', end - pos);
+        if (!next) {
+            break;
+        }
+        pos = (size_t)(next - s) + 1;
+        line++;
+    }
+    st->nnewline = line;
+    return NULL;
+}
+
+/**
+ * @brief Free the lists of a result
+ */
+static inline void utf8_lines_free(utf8_lines_t *res)
+{
+    if (res) {
+        free(res->bad);
+        free(res->bitmap);
+        *res = (utf8_lines_t){.nline = 0};
+    }
+}
+
+/**
+ * @brief Check whether a line is bad
+ *
+ * @return 1 if the line contains an illegal byte sequence, or 0 if it is
+ * valid or beyond the last line
+ */
+static inline int utf8_lines_isbad(const utf8_lines_t *res, size_t line)
+{
+    return line < res->nline && (res->bitmap[line / 64] >> (line % 64) & 1);
+}
+
+/**
+ * @brief Find the lines that contain illegal byte sequences
+ *
+ * The buffer is divided between the threads at newlines.
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param nthread Number of threads (0 selects the number of online CPUs)
+ * @param res Pointer to the result, to be freed with utf8_lines_free()
+ *
+ * @return The number of bad lines, or SIZE_MAX if parameters are invalid
+ * (and errno is set to EINVAL) or out of memory (and errno is set to
+ * ENOMEM)
+ */
+static inline size_t utf8_lines_validate(const unsigned char *s, size_t len,
+                                         size_t nthread, utf8_lines_t *res)
+{
+    utf8_lines_stripe_t *stripes = NULL;
+    size_t nbad                  = 0;
+    size_t base                  = 0;
+    size_t pos                   = 0;
+    int nomem                    = 0;
+
+    if ((!s && len) || !res) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    *res = (utf8_lines_t){.nline = 0};
+    if (!nthread) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthread   = ncpu > 0 ? (size_t)ncpu : 1;
+    }
+    if (nthread > UTF8_LINES_MAXTHREAD) {
+        nthread = UTF8_LINES_MAXTHREAD;
+    }
+    if (nthread > len / 4096 + 1) {
+        nthread = len / 4096 + 1;
+    }
+    stripes = calloc(nthread, sizeof(*stripes));
+    if (!stripes) {
+        errno = ENOMEM;
+        return SIZE_MAX;
+    }
+
+    // each stripe ends after the first newline past an even cut
+    for (size_t i = 0; i < nthread; i++) {
+        size_t end = i + 1 < nthread ? len / nthread * (i + 1) : len;
+
+        if (end < pos) {
+            end = pos;
+        } else if (end < len) {
+            const unsigned char *next = memchr(s + end, '\n', len - end);
+            end = next ? (size_t)(next - s) + 1 : len;
+        }
+        stripes[i] = (utf8_lines_stripe_t){.s = s, .start = pos, .end = end};
+        pos        = end;
+    }
+    for (size_t i = 1; i < nthread; i++) {
+        stripes[i].started = stripes[i].start < stripes[i].end &&
+                             !pthread_create(&stripes[i].thread, NULL,
+                                             utf8_lines_scan, &stripes[i]);
+    }
+    // the caller scans the first stripe and those without a thread
+    for (size_t i = 0; i < nthread; i++) {
+        if (!stripes[i].started) {
+            utf8_lines_scan(&stripes[i]);
+        }
+    }
+    for (size_t i = 1; i < nthread; i++) {
+        if (stripes[i].started) {
+            pthread_join(stripes[i].thread, NULL);
+        }
+    }
+
+    for (size_t i = 0; i < nthread; i++) {
+        nbad += stripes[i].nbad;
+        base += stripes[i].nnewline;
+        nomem |= stripes[i].nomem;
+    }
+    res->nline  = base + (len && s[len - 1] != '\n');
+    res->bad    = malloc((nbad ? nbad : 1) * sizeof(*res->bad));
+    res->bitmap = calloc(res->nline / 64 + 1, sizeof(*res->bitmap));
+    if (nomem || !res->bad || !res->bitmap) {
+        nomem = 1;
+    }
+
+    // line numbers of each stripe start after the newlines of the previous
+    base = 0;
+    for (size_t i = 0; i < nthread; i++) {
+        utf8_lines_stripe_t *st = &stripes[i];
+
+        for (size_t j = 0; !nomem && j < st->nbad; j++) {
+            size_t line = base + st->bad[j].line;
+
+            res->bad[res->nbad++] = (utf8_badline_t){.line   = line,
+                                                     .offset = st->bad[j].offset};
+            res->bitmap[line / 64] |= UINT64_C(1) << (line % 64);
+        }
+        base += st->nnewline;
+        free(st->bad);
+    }
+    free(stripes);
+    if (nomem) {
+        utf8_lines_free(res);
+        errno = ENOMEM;
+        return SIZE_MAX;
+    }
+    return res->nbad;
+}
+
+#endif
@@ -0,0 +1,464 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8parallel_h
+#define utf8parallel_h
+
+#include "utf8split.h"
+#include <pthread.h>
+#include <unistd.h>
+
+//
+// Parallel validation of large buffers.
+//
+// The buffer is divided into stripes that are validated by a pool of
+// threads. Each stripe boundary is moved to a character boundary with
+// utf8_boundary(), so no valid character is split between stripes; a stripe
+// that cannot be aligned within 3 bytes contains an illegal byte sequence
+// anyway. The first illegal byte sequence of the buffer is then the first
+// one found in any stripe.
+//
+// utf8_parallel_validlen() divides the buffer evenly between the threads.
+// utf8_parallel_validlen_numa() divides it into 2 MiB stripes, finds the
+// NUMA node of the memory of each stripe, and has threads pinned to each
+// node validate the stripes of that node first, so that most of the
+// buffer is read from local memory. The node of a stripe is queried with
+// move_pages(2), through libnuma if UTF8_PARALLEL_LIBNUMA is defined (link
+// with -lnuma). Stripes whose pages are not resident yet are assigned to the
+// nodes in contiguous blocks, so the pinned threads fault them in on their
+// own node, and the same assignment finds them local the next time.
+//
+// The NUMA placement requires Linux and _GNU_SOURCE; elsewhere
+// utf8_parallel_validlen_numa() behaves as utf8_parallel_validlen() with
+// 2 MiB stripes.
+//
+// Requires POSIX threads (compile with -pthread).
+//
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+# define UTF8_PARALLEL_NUMA 1
+# include <sched.h>
+# include <stdio.h>
+# ifdef UTF8_PARALLEL_LIBNUMA
+#  include <numa.h>
+#  include <numaif.h>
+# else
+#  include <sys/syscall.h>
+# endif
+#else
+# define UTF8_PARALLEL_NUMA 0
+#endif
+
+#define UTF8_PARALLEL_MAXTHREAD 256
+#define UTF8_PARALLEL_MAXNODE   64
+#define UTF8_PARALLEL_STRIPE    (2 * 1024 * 1024)
+
+typedef struct {
+    pthread_mutex_t lock;
+    const unsigned char *s;
+    size_t len;
+    size_t stripe;
+    size_t nstripe;
+    // stripe indices grouped by node, or NULL for stripes in order
+    size_t *order;
+    // order[first[n]] to order[first[n + 1] - 1] are the stripes of node n
+    size_t first[UTF8_PARALLEL_MAXNODE + 1];
+    size_t next[UTF8_PARALLEL_MAXNODE];
+    size_t nnode;
+    // offset of the first illegal byte sequence found so far
+    size_t illpos;
+#if UTF8_PARALLEL_NUMA
+    int pin;
+    cpu_set_t cpus[UTF8_PARALLEL_MAXNODE];
+#endif
+} utf8_parallel_job_t;
+
+typedef struct {
+    utf8_parallel_job_t *job;
+    size_t node;
+    pthread_t thread;
+} utf8_parallel_worker_t;
+
+/**
+ * @brief Validate the stripes of a job, those of the worker's node first
+ */
+static inline void *utf8_parallel_work(void *arg)
+{
+    utf8_parallel_worker_t *w = arg;
+    utf8_parallel_job_t *job  = w->job;
+
+#if UTF8_PARALLEL_NUMA
+    if (job->pin) {
+# ifdef UTF8_PARALLEL_LIBNUMA
+        numa_run_on_node((int)w->node);
+# else
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                               &job->cpus[w->node]);
+# endif
+    }
+#endif
+
+    for (size_t i = 0; i < job->nnode; i++) {
+        size_t node = (w->node + i) % job->nnode;
+
+        for (;;) {
+            size_t idx    = 0;
+            size_t head   = 0;
+            size_t tail   = 0;
+            size_t vlen   = 0;
+            size_t illpos = 0;
+
+            pthread_mutex_lock(&job->lock);
+            idx    = job->first[node] + job->next[node];
+            illpos = job->illpos;
+            if (idx < job->first[node + 1]) {
+                job->next[node]++;
+            }
+            pthread_mutex_unlock(&job->lock);
+            if (idx >= job->first[node + 1]) {
+                break;
+            }
+
+            if (job->order) {
+                idx = job->order[idx];
+            }
+            // the first stripe can not continue a character
+            head = idx ? utf8_boundary(job->s, job->len, idx * job->stripe)
+                       : 0;
+            tail = (idx + 1) * job->stripe;
+            tail = tail < job->len ? utf8_boundary(job->s, job->len, tail)
+                                   : job->len;
+            // an illegal byte sequence has already been found before it
+            if (head >= tail || head >= illpos) {
+                continue;
+            }
+            vlen = utf8_validlen(job->s + head, tail - head);
+            if (vlen < tail - head) {
+                pthread_mutex_lock(&job->lock);
+                if (head + vlen < job->illpos) {
+                    job->illpos = head + vlen;
+                }
+                pthread_mutex_unlock(&job->lock);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run the workers of a job and return the result
+ *
+ * @param nodes Node of each worker
+ */
+static inline size_t utf8_parallel_run(utf8_parallel_job_t *job,
+                                       size_t nthread, const size_t *nodes)
+{
+    utf8_parallel_worker_t workers[UTF8_PARALLEL_MAXTHREAD];
+    size_t n = 0;
+
+    pthread_mutex_init(&job->lock, NULL);
+    job->illpos = job->len;
+    for (; n < nthread; n++) {
+        workers[n] = (utf8_parallel_worker_t){.job = job, .node = nodes[n]};
+        if (pthread_create(&workers[n].thread, NULL, utf8_parallel_work,
+                           &workers[n])) {
+            break;
+        }
+    }
+    // if no thread could be created, the caller validates all stripes
+    if (!n) {
+        workers[0] = (utf8_parallel_worker_t){.job = job};
+#if UTF8_PARALLEL_NUMA
+        job->pin = 0;
+#endif
+        utf8_parallel_work(&workers[0]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    pthread_mutex_destroy(&job->lock);
+    return job->illpos;
+}
+
+/**
+ * @brief Get the number of threads to use
+ */
+static inline size_t utf8_parallel_nthread(size_t nthread)
+{
+    if (!nthread) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthread   = ncpu > 0 ? (size_t)ncpu : 1;
+    }
+    return nthread < UTF8_PARALLEL_MAXTHREAD ? nthread
+                                             : UTF8_PARALLEL_MAXTHREAD;
+}
+
+/**
+ * @brief Find the first illegal byte sequence with a pool of threads
+ *
+ * The buffer is divided evenly between the threads, regardless of where its
+ * memory is.
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param nthread Number of threads (0 selects the number of online CPUs)
+ *
+ * @return The offset of the first illegal byte sequence, or len if the
+ * buffer is valid, or SIZE_MAX if parameters are invalid (and errno is set
+ * to EINVAL)
+ */
+static inline size_t utf8_parallel_validlen(const unsigned char *s,
+                                            size_t len, size_t nthread)
+{
+    static const size_t nodes[UTF8_PARALLEL_MAXTHREAD];
+    utf8_parallel_job_t *job = NULL;
+    size_t illpos            = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    nthread = utf8_parallel_nthread(nthread);
+    if (nthread == 1 || len < nthread) {
+        return utf8_validlen(s, len);
+    }
+    job = calloc(1, sizeof(*job));
+    if (!job) {
+        return utf8_validlen(s, len);
+    }
+
+    job->s        = s;
+    job->len      = len;
+    job->stripe   = (len + nthread - 1) / nthread;
+    job->nstripe  = (len + job->stripe - 1) / job->stripe;
+    job->nnode    = 1;
+    job->first[1] = job->nstripe;
+    illpos        = utf8_parallel_run(job, nthread, nodes);
+    free(job);
+    return illpos;
+}
+
+#if UTF8_PARALLEL_NUMA
+
+/**
+ * @brief Find the nodes that have CPUs and their CPU sets
+ *
+ * @return The number of nodes, or 0 if the system has no NUMA information
+ */
+static inline size_t utf8_parallel_nodes(cpu_set_t *cpus, int *ids)
+{
+    size_t nnode = 0;
+
+# ifdef UTF8_PARALLEL_LIBNUMA
+    struct bitmask *mask = NULL;
+    int maxnode          = 0;
+
+    if (numa_available() < 0) {
+        return 0;
+    }
+    mask    = numa_allocate_cpumask();
+    maxnode = numa_max_node();
+    for (int id = 0; id <= maxnode && nnode < UTF8_PARALLEL_MAXNODE; id++) {
+        CPU_ZERO(&cpus[nnode]);
+        if (numa_node_to_cpus(id, mask) == 0) {
+            for (unsigned int cpu = 0; cpu < mask->size && cpu < CPU_SETSIZE;
+                 cpu++) {
+                if (numa_bitmask_isbitset(mask, cpu)) {
+                    CPU_SET((size_t)cpu, &cpus[nnode]);
+                }
+            }
+        }
+        if (CPU_COUNT(&cpus[nnode])) {
+            ids[nnode++] = id;
+        }
+    }
+    numa_free_cpumask(mask);
+# else
+    // cpulist is a list of ranges such as "0-15,32-47"
+    for (int id = 0; nnode < UTF8_PARALLEL_MAXNODE; id++) {
+        char path[64];
+        FILE *fp  = NULL;
+        int lo    = 0;
+        int hi    = 0;
+        int count = 0;
+
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%d/cpulist", id);
+        fp = fopen(path, "r");
+        if (!fp) {
+            // node ids are dense on almost all systems
+            if (id > 2 * UTF8_PARALLEL_MAXNODE) {
+                break;
+            }
+            continue;
+        }
+        CPU_ZERO(&cpus[nnode]);
+        while ((count = fscanf(fp, "%d-%d", &lo, &hi)) >= 1) {
+            if (count == 1) {
+                hi = lo;
+            }
+            for (int cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+                CPU_SET((size_t)cpu, &cpus[nnode]);
+            }
+            if (fgetc(fp) != ',') {
+                break;
+            }
+        }
+        fclose(fp);
+        if (CPU_COUNT(&cpus[nnode])) {
+            ids[nnode++] = id;
+        }
+    }
+# endif
+    return nnode;
+}
+
+/**
+ * @brief Query the node of the first page of each stripe
+ *
+ * @param status Receives the node id of each stripe, or a negative value if
+ * its page is not resident
+ */
+static inline void utf8_parallel_locate(const unsigned char *s,
+                                        size_t nstripe, size_t stripe,
+                                        int *status)
+{
+    uintptr_t pagesize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    void *pages[1024];
+
+    for (size_t i = 0; i < nstripe; i += 1024) {
+        size_t n = nstripe - i < 1024 ? nstripe - i : 1024;
+
+        for (size_t j = 0; j < n; j++) {
+            uintptr_t addr = (uintptr_t)(s + (i + j) * stripe);
+            pages[j]       = (void *)(addr & ~(pagesize - 1));
+        }
+# ifdef UTF8_PARALLEL_LIBNUMA
+        if (numa_move_pages(0, (unsigned long)n, pages, NULL, status + i, 0)) {
+# else
+        if (syscall(SYS_move_pages, 0, (unsigned long)n, pages, NULL,
+                    status + i, 0)) {
+# endif
+            for (size_t j = 0; j < n; j++) {
+                status[i + j] = -1;
+            }
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Find the first illegal byte sequence with threads pinned to the
+ * NUMA nodes of the buffer
+ *
+ * @param s Pointer to a buffer (e.g. a mapping of a large file)
+ * @param len Number of bytes in the buffer
+ * @param nthread Number of threads (0 selects the number of online CPUs),
+ * spread over the nodes
+ *
+ * @return The offset of the first illegal byte sequence, or len if the
+ * buffer is valid, or SIZE_MAX if parameters are invalid (and errno is set
+ * to EINVAL)
+ */
+static inline size_t utf8_parallel_validlen_numa(const unsigned char *s,
+                                                 size_t len, size_t nthread)
+{
+    size_t nodes[UTF8_PARALLEL_MAXTHREAD] = {0};
+    utf8_parallel_job_t *job              = NULL;
+    size_t illpos                         = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    nthread = utf8_parallel_nthread(nthread);
+    if (nthread == 1 || len <= UTF8_PARALLEL_STRIPE) {
+        return utf8_validlen(s, len);
+    }
+    job = calloc(1, sizeof(*job));
+    if (!job) {
+        return utf8_validlen(s, len);
+    }
+    job->s       = s;
+    job->len     = len;
+    job->stripe  = UTF8_PARALLEL_STRIPE;
+    job->nstripe = (len + job->stripe - 1) / job->stripe;
+    job->nnode   = 1;
+
+#if UTF8_PARALLEL_NUMA
+    {
+        int ids[UTF8_PARALLEL_MAXNODE];
+        int *status = NULL;
+        size_t nnode = utf8_parallel_nodes(job->cpus, ids);
+
+        if (nnode > 1) {
+            job->order = malloc(job->nstripe * sizeof(*job->order));
+            status     = malloc(job->nstripe * sizeof(*status));
+        }
+        if (job->order && status) {
+            size_t count[UTF8_PARALLEL_MAXNODE] = {0};
+
+            utf8_parallel_locate(s, job->nstripe, job->stripe, status);
+            // map node ids to indices; stripes that are not resident are
+            // assigned to the nodes in contiguous blocks (first touch)
+            for (size_t i = 0; i < job->nstripe; i++) {
+                size_t node = i * nnode / job->nstripe;
+                for (size_t n = 0; n < nnode; n++) {
+                    if (status[i] == ids[n]) {
+                        node = n;
+                        break;
+                    }
+                }
+                status[i] = (int)node;
+                count[node]++;
+            }
+            // group the stripes by node, keeping their order
+            for (size_t n = 0; n < nnode; n++) {
+                job->first[n + 1] = job->first[n] + count[n];
+                count[n]          = job->first[n];
+            }
+            for (size_t i = 0; i < job->nstripe; i++) {
+                job->order[count[status[i]]++] = i;
+            }
+            for (size_t i = 0; i < nthread; i++) {
+                nodes[i] = i % nnode;
+            }
+            job->nnode = nnode;
+            job->pin   = 1;
+        } else {
+            free(job->order);
+            job->order = NULL;
+        }
+        free(status);
+    }
+#endif
+
+    job->first[job->nnode] = job->nstripe;
+    illpos                 = utf8_parallel_run(job, nthread, nodes);
+    free(job->order);
+    free(job);
+    return illpos;
+}
+
+#endif
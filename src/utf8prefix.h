@@ -0,0 +1,124 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8prefix_h
+#define utf8prefix_h
+
+#include "utf8valid.h"
+
+/**
+ * @brief Find the first differing byte of two buffers
+ *
+ * @param a Pointer to a buffer
+ * @param b Pointer to a buffer
+ * @param n Number of bytes to compare
+ *
+ * @return The offset of the first differing byte, or n if the buffers are
+ * equal
+ */
+static inline size_t utf8_mismatch(const unsigned char *a,
+                                   const unsigned char *b, size_t n)
+{
+    size_t pos = 0;
+
+    for (; pos + 8 <= n; pos += 8) {
+        uint64_t va, vb;
+        memcpy(&va, a + pos, 8);
+        memcpy(&vb, b + pos, 8);
+        if (va != vb) {
+            break;
+        }
+    }
+    while (pos < n && a[pos] == b[pos]) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * @brief Determine the longest common prefix ending at a character boundary
+ *
+ * The buffers are compared eight bytes at a time, and the first mismatch is
+ * moved back to the start of the character that contains it, so the prefix
+ * never ends in the middle of a character of either buffer.
+ *
+ * @param a Pointer to a buffer
+ * @param alen Number of bytes in a
+ * @param b Pointer to a buffer
+ * @param blen Number of bytes in b
+ *
+ * @return The byte length of the common prefix, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_common_prefix(const unsigned char *a, size_t alen,
+                                        const unsigned char *b, size_t blen)
+{
+    size_t pos = 0;
+
+    if ((!a && alen) || (!b && blen)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+#define is_utf8tail(c) (((c) & 0xC0) == 0x80)
+
+    pos = utf8_mismatch(a, b, alen < blen ? alen : blen);
+    // a continuation byte on either side means the prefix would split a
+    // character; both sides are equal before pos
+    while (pos > 0 && ((pos < alen && is_utf8tail(a[pos])) ||
+                       (pos < blen && is_utf8tail(b[pos])))) {
+        pos--;
+    }
+    return pos;
+
+#undef is_utf8tail
+}
+
+/**
+ * @brief Determine the longest valid common prefix
+ *
+ * Same as utf8_common_prefix() but the prefix is also cut at the first
+ * illegal byte sequence, so it is always valid UTF-8.
+ *
+ * @param a Pointer to a buffer
+ * @param alen Number of bytes in a
+ * @param b Pointer to a buffer
+ * @param blen Number of bytes in b
+ *
+ * @return The byte length of the common prefix, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_common_validprefix(const unsigned char *a,
+                                             size_t alen,
+                                             const unsigned char *b,
+                                             size_t blen)
+{
+    size_t len = utf8_common_prefix(a, alen, b, blen);
+
+    if (len == SIZE_MAX) {
+        return SIZE_MAX;
+    }
+    return utf8_validlen(a, len);
+}
+
+#endif
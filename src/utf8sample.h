@@ -0,0 +1,273 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8sample_h
+#define utf8sample_h
+
+#include "utf8split.h"
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Sampling validation for a quick first pass over huge inputs.
+//
+// Instead of the whole input, nwindow windows of about window bytes are
+// validated. Both ends of each window are moved forward to the start of a
+// character with utf8_boundary(), so a window never starts or ends inside
+// a valid character; the continuation bytes skipped at the start are
+// checked against the up to 3 bytes before the window, and a window at the
+// start of the input is not moved. The result is the number of windows
+// that contain an illegal byte sequence, from which the rate of bad
+// windows in the whole input is estimated with a Wilson score interval.
+//
+// With seed 0 the windows are evenly strided; any other seed places them
+// at pseudo-random offsets that only depend on the seed and the window
+// index, so a sample can be reproduced exactly.
+//
+// utf8_sample_fd() reads only the windows of a file with pread(), and
+// requires POSIX.1-2008. Link with -lm for sqrt().
+//
+
+typedef struct {
+    size_t nwindow;
+    // windows that contain an illegal byte sequence
+    size_t nbad;
+    // bytes validated
+    uint64_t nbytes;
+    // offset of the first illegal byte sequence of the first bad window, or
+    // UINT64_MAX
+    uint64_t first_bad;
+} utf8_sample_t;
+
+/**
+ * @brief Get the offset of a window (splitmix64 for random windows)
+ */
+static inline uint64_t utf8_sample_offset(uint64_t size, size_t window,
+                                          size_t nwindow, size_t i,
+                                          uint64_t seed)
+{
+    uint64_t range = size > window ? size - window : 0;
+    uint64_t x     = 0;
+
+    if (!seed) {
+        return nwindow > 1 ? range / (nwindow - 1) * i : 0;
+    }
+    x = seed + UINT64_C(0x9E3779B97F4A7C15) * (i + 1);
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+    x ^= x >> 31;
+    return x % (range + 1);
+}
+
+/**
+ * @brief Validate one window and add it to a sample
+ *
+ * @param s Pointer to the bytes around the window
+ * @param len Number of bytes at s, including up to 3 bytes after the window
+ * @param lo Offset of the window in s, after up to 3 bytes before the window
+ * (fewer only at the start of the input)
+ * @param hi Offset of the end of the window in s
+ * @param base Offset of s in the input
+ */
+static inline void utf8_sample_window(utf8_sample_t *res,
+                                      const unsigned char *s, size_t len,
+                                      size_t lo, size_t hi, uint64_t base)
+{
+    size_t start = base + lo ? utf8_boundary(s, len, lo) : lo;
+    size_t end   = utf8_boundary(s, len, hi);
+    size_t vlen  = 0;
+    uint64_t bad = UINT64_MAX;
+
+    if (start >= end) {
+        return;
+    }
+    // the skipped continuation bytes must finish a character that starts
+    // at most 3 bytes before the window
+    if (start > lo) {
+        size_t pos = lo;
+
+        while (pos > 0 && lo - pos < 3 && (s[pos] & 0xC0) == 0x80) {
+            pos--;
+        }
+        if ((s[pos] & 0xC0) == 0x80) {
+            bad = base + pos;
+        } else if ((vlen = utf8_validlen(s + pos, start - pos)) <
+                   start - pos) {
+            bad = base + pos + vlen;
+        }
+    }
+    vlen = utf8_validlen(s + start, end - start);
+    res->nwindow++;
+    res->nbytes += end - start;
+    if (vlen < end - start && bad == UINT64_MAX) {
+        bad = base + start + vlen;
+    }
+    if (bad != UINT64_MAX) {
+        res->nbad++;
+        if (bad < res->first_bad) {
+            res->first_bad = bad;
+        }
+    }
+}
+
+/**
+ * @brief Validate sampled windows of a buffer
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param nwindow Number of windows
+ * @param window Size of each window in bytes
+ * @param seed 0 for strided windows, or the seed of random windows
+ * @param res Pointer to the result
+ *
+ * @return The number of bad windows, or SIZE_MAX if parameters are invalid
+ * (and errno is set to EINVAL)
+ */
+static inline size_t utf8_sample(const unsigned char *s, size_t len,
+                                 size_t nwindow, size_t window, uint64_t seed,
+                                 utf8_sample_t *res)
+{
+    if ((!s && len) || !res || !window) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    *res = (utf8_sample_t){.first_bad = UINT64_MAX};
+
+    for (size_t i = 0; i < nwindow; i++) {
+        size_t lo = (size_t)utf8_sample_offset(len, window, nwindow, i, seed);
+        size_t hi = len - lo > window ? lo + window : len;
+
+        utf8_sample_window(res, s, len, lo, hi, 0);
+    }
+    return res->nbad;
+}
+
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L
+
+/**
+ * @brief Validate sampled windows of a file, reading only the windows
+ *
+ * @param fd File descriptor of a regular file
+ * @param nwindow Number of windows
+ * @param window Size of each window in bytes
+ * @param seed 0 for strided windows, or the seed of random windows
+ * @param res Pointer to the result
+ *
+ * @return The number of bad windows, or SIZE_MAX if parameters are invalid
+ * (and errno is set to EINVAL) or on a read error (and errno is set by
+ * fstat() or pread(), or to ENOMEM)
+ */
+static inline size_t utf8_sample_fd(int fd, size_t nwindow, size_t window,
+                                    uint64_t seed, utf8_sample_t *res)
+{
+    unsigned char *buf = NULL;
+    struct stat st;
+    uint64_t size = 0;
+
+    if (!res || !window || window > SIZE_MAX - 6) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    if (fstat(fd, &st) != 0) {
+        return SIZE_MAX;
+    }
+    *res = (utf8_sample_t){.first_bad = UINT64_MAX};
+    size = (uint64_t)st.st_size;
+    buf  = malloc(window + 6);
+    if (!buf) {
+        errno = ENOMEM;
+        return SIZE_MAX;
+    }
+
+    for (size_t i = 0; i < nwindow; i++) {
+        uint64_t off = utf8_sample_offset(size, window, nwindow, i, seed);
+        size_t lo    = off > 3 ? 3 : (size_t)off;
+        size_t want  = 0;
+        size_t n     = 0;
+
+        // the 3 bytes before and after the window are read to check its
+        // start and align its end
+        off -= lo;
+        want = size - off > lo + window + 3 ? lo + window + 3
+                                            : (size_t)(size - off);
+        while (n < want) {
+            ssize_t nr = pread(fd, buf + n, want - n, (off_t)(off + n));
+
+            if (nr < 0 && errno == EINTR) {
+                continue;
+            } else if (nr <= 0) {
+                if (nr == 0) {
+                    break;
+                }
+                free(buf);
+                return SIZE_MAX;
+            }
+            n += (size_t)nr;
+        }
+        lo = lo < n ? lo : n;
+        utf8_sample_window(res, buf, n, lo, n - lo > window ? lo + window : n,
+                           off);
+    }
+    free(buf);
+    return res->nbad;
+}
+
+#endif
+
+/**
+ * @brief Wilson score interval of the rate of bad windows
+ *
+ * @param res Pointer to a sample
+ * @param z Standard score of the confidence level (1.96 for 95%)
+ * @param lower Pointer to a double that receives the lower bound, or NULL
+ *
+ * @return The upper bound of the rate of bad windows (0-1), or 1 if no
+ * window was validated
+ */
+static inline double utf8_sample_bound(const utf8_sample_t *res, double z,
+                                       double *lower)
+{
+    double n      = (double)res->nwindow;
+    double p      = 0;
+    double center = 0;
+    double spread = 0;
+    double denom  = 0;
+
+    if (!res->nwindow) {
+        if (lower) {
+            *lower = 0;
+        }
+        return 1;
+    }
+    p      = (double)res->nbad / n;
+    denom  = 1 + z * z / n;
+    center = p + z * z / (2 * n);
+    spread = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n));
+    if (lower) {
+        *lower = center > spread ? (center - spread) / denom : 0;
+    }
+    return (center + spread) / denom < 1 ? (center + spread) / denom : 1;
+}
+
+#endif
@@ -0,0 +1,425 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8service_h
+#define utf8service_h
+
+#include "utf8valid.h"
+#include <pthread.h>
+
+//
+// Asynchronous validation service.
+//
+// Request threads submit jobs (a buffer and an optional callback) to a
+// small pool of validator threads instead of validating inline. Each
+// validator thread owns a lock-free multi-producer single-consumer queue
+// (an intrusive linked list, as described by D. Vyukov); a job is pushed to
+// a queue chosen by its address with a single atomic exchange. A validator
+// drains its queue in batches and validates the jobs back to back, then
+// either calls the callback of each job or marks it done, waking a thread
+// blocked in utf8_service_wait().
+//
+// Validator threads sleep on a futex while their queues are empty (on Linux
+// with _GNU_SOURCE; elsewhere on a condition variable), and are only woken
+// when a job is submitted to a sleeping validator.
+//
+// Requires POSIX threads (compile with -pthread) and the __atomic builtins
+// of GCC or Clang.
+//
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+# define UTF8_SERVICE_FUTEX 1
+# include <limits.h>
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#else
+# define UTF8_SERVICE_FUTEX 0
+#endif
+
+#define UTF8_SERVICE_BATCH 64
+
+#define UTF8_SERVICE_PENDING 0
+#define UTF8_SERVICE_WAITING 1
+#define UTF8_SERVICE_DONE    2
+
+typedef struct utf8_service_job {
+    struct utf8_service_job *next;
+    const unsigned char *s;
+    size_t len;
+    // offset of the first illegal byte sequence, or len if s is valid
+    size_t illpos;
+    // called on the validator thread when the job is done, if not NULL;
+    // the job is then not marked done
+    void (*callback)(struct utf8_service_job *job);
+    void *udata;
+    uint32_t state;
+} utf8_service_job_t;
+
+typedef struct utf8_service utf8_service_t;
+
+typedef struct {
+    // producers push at the head and the validator pops at the tail
+    utf8_service_job_t *head;
+    utf8_service_job_t *tail;
+    utf8_service_job_t stub;
+    // incremented by each push, the word the validator sleeps on
+    uint32_t seq;
+    uint32_t sleeping;
+    utf8_service_t *svc;
+    pthread_t thread;
+#if !UTF8_SERVICE_FUTEX
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+} utf8_service_queue_t;
+
+struct utf8_service {
+    uint32_t stop;
+#if !UTF8_SERVICE_FUTEX
+    // for threads blocked in utf8_service_wait()
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+    size_t nqueue;
+    utf8_service_queue_t queues[];
+};
+
+#if UTF8_SERVICE_FUTEX
+
+static inline void utf8_service_futex_wait(uint32_t *addr, uint32_t val)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static inline void utf8_service_futex_wake(uint32_t *addr, int n)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+#endif
+
+/**
+ * @brief Push a job to a queue (any thread)
+ */
+static inline void utf8_service_push(utf8_service_queue_t *q,
+                                     utf8_service_job_t *job)
+{
+    utf8_service_job_t *prev = NULL;
+
+    __atomic_store_n(&job->next, NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&q->head, job, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, job, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Pop a job from a queue (validator thread only)
+ *
+ * @return The oldest job, or NULL if the queue is empty or a push is not
+ * complete yet
+ */
+static inline utf8_service_job_t *utf8_service_pop(utf8_service_queue_t *q)
+{
+    utf8_service_job_t *tail = q->tail;
+    utf8_service_job_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &q->stub) {
+        if (!next) {
+            return NULL;
+        }
+        q->tail = next;
+        tail    = next;
+        next    = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        q->tail = next;
+        return tail;
+    } else if (tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    // tail is the last job; put the stub behind it to take it
+    utf8_service_push(q, &q->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finish a job (validator thread)
+ */
+static inline void utf8_service_complete(utf8_service_t *svc,
+                                         utf8_service_job_t *job)
+{
+    uint32_t prev = 0;
+
+    if (job->callback) {
+        job->callback(job);
+        return;
+    }
+    prev = __atomic_exchange_n(&job->state, UTF8_SERVICE_DONE,
+                               __ATOMIC_ACQ_REL);
+    if (prev == UTF8_SERVICE_WAITING) {
+#if UTF8_SERVICE_FUTEX
+        (void)svc;
+        utf8_service_futex_wake(&job->state, INT_MAX);
+#else
+        pthread_mutex_lock(&svc->lock);
+        pthread_cond_broadcast(&svc->cond);
+        pthread_mutex_unlock(&svc->lock);
+#endif
+    }
+}
+
+/**
+ * @brief Main loop of a validator thread
+ */
+static inline void *utf8_service_main(void *arg)
+{
+    utf8_service_queue_t *q = arg;
+    utf8_service_t *svc     = q->svc;
+    utf8_service_job_t *batch[UTF8_SERVICE_BATCH];
+
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&q->seq, __ATOMIC_SEQ_CST);
+        size_t n     = 0;
+
+        while (n < UTF8_SERVICE_BATCH && (batch[n] = utf8_service_pop(q))) {
+            n++;
+        }
+        if (n) {
+            for (size_t i = 0; i < n; i++) {
+                batch[i]->illpos = utf8_validlen(batch[i]->s, batch[i]->len);
+            }
+            for (size_t i = 0; i < n; i++) {
+                utf8_service_complete(svc, batch[i]);
+            }
+            continue;
+        } else if (__atomic_load_n(&svc->stop, __ATOMIC_SEQ_CST)) {
+            return NULL;
+        }
+
+        // sleep unless a job has been pushed since the queue was read
+        __atomic_store_n(&q->sleeping, 1, __ATOMIC_SEQ_CST);
+#if UTF8_SERVICE_FUTEX
+        if (__atomic_load_n(&q->seq, __ATOMIC_SEQ_CST) == seq) {
+            utf8_service_futex_wait(&q->seq, seq);
+        }
+#else
+        pthread_mutex_lock(&q->lock);
+        while (__atomic_load_n(&q->seq, __ATOMIC_SEQ_CST) == seq) {
+            pthread_cond_wait(&q->cond, &q->lock);
+        }
+        pthread_mutex_unlock(&q->lock);
+#endif
+        __atomic_store_n(&q->sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * @brief Wake a validator thread after its sequence has changed
+ */
+static inline void utf8_service_wake(utf8_service_queue_t *q)
+{
+    __atomic_add_fetch(&q->seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->sleeping, __ATOMIC_SEQ_CST)) {
+#if UTF8_SERVICE_FUTEX
+        utf8_service_futex_wake(&q->seq, 1);
+#else
+        pthread_mutex_lock(&q->lock);
+        pthread_cond_signal(&q->cond);
+        pthread_mutex_unlock(&q->lock);
+#endif
+    }
+}
+
+/**
+ * @brief Stop the validator threads and free a service
+ *
+ * The jobs that have been submitted are finished first. No job may be
+ * submitted during or after this call.
+ */
+static inline void utf8_service_free(utf8_service_t *svc)
+{
+    if (!svc) {
+        return;
+    }
+    __atomic_store_n(&svc->stop, 1, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < svc->nqueue; i++) {
+        utf8_service_wake(&svc->queues[i]);
+    }
+    for (size_t i = 0; i < svc->nqueue; i++) {
+        pthread_join(svc->queues[i].thread, NULL);
+#if !UTF8_SERVICE_FUTEX
+        pthread_cond_destroy(&svc->queues[i].cond);
+        pthread_mutex_destroy(&svc->queues[i].lock);
+#endif
+    }
+#if !UTF8_SERVICE_FUTEX
+    pthread_cond_destroy(&svc->cond);
+    pthread_mutex_destroy(&svc->lock);
+#endif
+    free(svc);
+}
+
+/**
+ * @brief Create a validation service
+ *
+ * @param nthread Number of validator threads (0 selects 1)
+ *
+ * @return Pointer to the service, or NULL on failure (and errno is set)
+ */
+static inline utf8_service_t *utf8_service_new(size_t nthread)
+{
+    utf8_service_t *svc = NULL;
+
+    if (!nthread) {
+        nthread = 1;
+    }
+    svc = calloc(1, sizeof(*svc) + nthread * sizeof(utf8_service_queue_t));
+    if (!svc) {
+        return NULL;
+    }
+#if !UTF8_SERVICE_FUTEX
+    pthread_mutex_init(&svc->lock, NULL);
+    pthread_cond_init(&svc->cond, NULL);
+#endif
+
+    for (; svc->nqueue < nthread; svc->nqueue++) {
+        utf8_service_queue_t *q = &svc->queues[svc->nqueue];
+        int rc                  = 0;
+
+        q->head = &q->stub;
+        q->tail = &q->stub;
+        q->svc  = svc;
+#if !UTF8_SERVICE_FUTEX
+        pthread_mutex_init(&q->lock, NULL);
+        pthread_cond_init(&q->cond, NULL);
+#endif
+        rc = pthread_create(&q->thread, NULL, utf8_service_main, q);
+        if (rc) {
+#if !UTF8_SERVICE_FUTEX
+            pthread_cond_destroy(&q->cond);
+            pthread_mutex_destroy(&q->lock);
+#endif
+            utf8_service_free(svc);
+            errno = rc;
+            return NULL;
+        }
+    }
+    return svc;
+}
+
+/**
+ * @brief Initialize a job
+ *
+ * @param job Pointer to the job, which must stay valid until it is done
+ * @param s Pointer to the buffer to validate
+ * @param len Number of bytes in the buffer
+ * @param callback Function called on a validator thread when the job is
+ * done, or NULL to use utf8_service_poll() and utf8_service_wait()
+ * @param udata User data for the callback
+ */
+static inline void utf8_service_job_init(
+    utf8_service_job_t *job, const unsigned char *s, size_t len,
+    void (*callback)(utf8_service_job_t *job), void *udata)
+{
+    *job = (utf8_service_job_t){
+        .s        = s,
+        .len      = len,
+        .callback = callback,
+        .udata    = udata,
+    };
+}
+
+/**
+ * @brief Submit a job
+ *
+ * @param svc Pointer to the service
+ * @param job Pointer to a job initialized by utf8_service_job_init()
+ *
+ * @return 0 on success, or -1 if parameters are invalid (and errno is set to
+ * EINVAL)
+ */
+static inline int utf8_service_submit(utf8_service_t *svc,
+                                      utf8_service_job_t *job)
+{
+    utf8_service_queue_t *q = NULL;
+
+    if (!svc || !job || (!job->s && job->len)) {
+        errno = EINVAL;
+        return -1;
+    }
+    // jobs are spread over the queues by address, without shared state
+    q = &svc->queues[((uintptr_t)job / sizeof(*job)) % svc->nqueue];
+    job->state = UTF8_SERVICE_PENDING;
+    utf8_service_push(q, job);
+    utf8_service_wake(q);
+    return 0;
+}
+
+/**
+ * @brief Check whether a job without a callback is done
+ *
+ * @return 1 if the job is done and job->illpos is set, or 0 if not yet
+ */
+static inline int utf8_service_poll(utf8_service_job_t *job)
+{
+    return __atomic_load_n(&job->state, __ATOMIC_ACQUIRE) ==
+           UTF8_SERVICE_DONE;
+}
+
+/**
+ * @brief Wait until a job without a callback is done
+ *
+ * @return The offset of the first illegal byte sequence, or the length of
+ * the buffer if it is valid
+ */
+static inline size_t utf8_service_wait(utf8_service_t *svc,
+                                       utf8_service_job_t *job)
+{
+    uint32_t state = UTF8_SERVICE_PENDING;
+
+#if UTF8_SERVICE_FUTEX
+    (void)svc;
+    while (!utf8_service_poll(job)) {
+        state = UTF8_SERVICE_PENDING;
+        __atomic_compare_exchange_n(&job->state, &state, UTF8_SERVICE_WAITING,
+                                    0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        utf8_service_futex_wait(&job->state, UTF8_SERVICE_WAITING);
+    }
+#else
+    pthread_mutex_lock(&svc->lock);
+    __atomic_compare_exchange_n(&job->state, &state, UTF8_SERVICE_WAITING, 0,
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    while (!utf8_service_poll(job)) {
+        pthread_cond_wait(&svc->cond, &svc->lock);
+    }
+    pthread_mutex_unlock(&svc->lock);
+#endif
+    return job->illpos;
+}
+
+#endif
@@ -0,0 +1,619 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8sink_h
+#define utf8sink_h
+
+#include "utf8valid.h"
+#include <unistd.h>
+
+//
+// Output sinks for transforming operations.
+//
+// A sink is a window of writable bytes (buf, len, cap) plus a function that
+// makes room when the window is full. Transforms write straight into the
+// window, so no intermediate buffer is needed. Three kinds are provided:
+//
+//  fixed:    a caller buffer. Writing past its end fails with ENOBUFS.
+//  builder:  a growable buffer allocated from an arena. It grows in place
+//            while it is the last allocation of the arena, and everything
+//            built for a request is freed at once with the arena.
+//  callback: a caller buffer that is handed to a function whenever it is
+//            full, e.g. utf8_sink_fd() writes it to a file descriptor.
+//            Writes larger than the buffer bypass it.
+//
+// The transforms of utf8escape.h are implemented here on sinks, and need no
+// size pass as the output is produced in one pass over the input;
+// utf8escape.h runs them on a fixed sink over its destination buffer.
+//
+
+#define UTF8_ARENA_BLOCK 65536
+#define UTF8_ARENA_ALIGN 16
+
+typedef struct utf8_arena_block {
+    struct utf8_arena_block *next;
+    size_t size;
+    size_t used;
+    unsigned char data[];
+} utf8_arena_block_t;
+
+typedef struct {
+    utf8_arena_block_t *head;
+    size_t blocksize;
+} utf8_arena_t;
+
+typedef int (*utf8_sink_fn)(void *ctx, const unsigned char *p, size_t n);
+
+typedef struct utf8_sink {
+    unsigned char *buf;
+    size_t len;
+    size_t cap;
+    // bytes handed to fn so far
+    size_t flushed;
+    // makes room for at least need more bytes, returns 0 or -1
+    int (*grow)(struct utf8_sink *sink, size_t need);
+    utf8_sink_fn fn;
+    void *ctx;
+    utf8_arena_t *arena;
+} utf8_sink_t;
+
+/**
+ * @brief Initialize an arena
+ *
+ * @param arena Pointer to the arena
+ * @param blocksize Size of the blocks taken from malloc (0 selects
+ * UTF8_ARENA_BLOCK)
+ */
+static inline void utf8_arena_init(utf8_arena_t *arena, size_t blocksize)
+{
+    arena->head      = NULL;
+    arena->blocksize = blocksize ? blocksize : UTF8_ARENA_BLOCK;
+}
+
+/**
+ * @brief Free all allocations of an arena
+ *
+ * The arena can be used again.
+ */
+static inline void utf8_arena_free(utf8_arena_t *arena)
+{
+    while (arena->head) {
+        utf8_arena_block_t *next = arena->head->next;
+
+        free(arena->head);
+        arena->head = next;
+    }
+}
+
+/**
+ * @brief Allocate memory from an arena
+ *
+ * @param arena Pointer to the arena
+ * @param n Number of bytes
+ *
+ * @return Pointer to n bytes aligned to UTF8_ARENA_ALIGN, or NULL if out of
+ * memory (and errno is set to ENOMEM)
+ */
+static inline void *utf8_arena_alloc(utf8_arena_t *arena, size_t n)
+{
+    utf8_arena_block_t *b = arena->head;
+    size_t start          = 0;
+
+    if (b) {
+        start = b->used + (UTF8_ARENA_ALIGN -
+                           (uintptr_t)(b->data + b->used) % UTF8_ARENA_ALIGN) %
+                              UTF8_ARENA_ALIGN;
+    }
+    if (!b || start > b->size || n > b->size - start) {
+        size_t size = n > arena->blocksize ? n : arena->blocksize;
+
+        if (size > SIZE_MAX - sizeof(*b) - UTF8_ARENA_ALIGN) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        // with room to align the first allocation
+        b = malloc(sizeof(*b) + size + UTF8_ARENA_ALIGN);
+        if (!b) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        b->next     = arena->head;
+        b->size     = size + UTF8_ARENA_ALIGN;
+        arena->head = b;
+        start = (UTF8_ARENA_ALIGN - (uintptr_t)b->data % UTF8_ARENA_ALIGN) %
+                UTF8_ARENA_ALIGN;
+    }
+    b->used = start + n;
+    return b->data + start;
+}
+
+/**
+ * @brief Grow a fixed sink (always fails)
+ */
+static inline int utf8_sink_grow_fixed(utf8_sink_t *sink, size_t need)
+{
+    (void)sink;
+    (void)need;
+    errno = ENOBUFS;
+    return -1;
+}
+
+/**
+ * @brief Grow a builder, in place if it is the last allocation of its arena
+ */
+static inline int utf8_sink_grow_builder(utf8_sink_t *sink, size_t need)
+{
+    utf8_arena_block_t *b = sink->arena->head;
+    size_t cap            = sink->cap ? sink->cap : 64;
+    unsigned char *buf    = NULL;
+
+    if (need > SIZE_MAX / 2 - sink->len) {
+        errno = ENOMEM;
+        return -1;
+    }
+    while (cap - sink->len < need) {
+        cap *= 2;
+    }
+    if (b && sink->buf && sink->buf + sink->cap == b->data + b->used &&
+        cap - sink->cap <= b->size - b->used) {
+        b->used += cap - sink->cap;
+        sink->cap = cap;
+        return 0;
+    }
+    buf = utf8_arena_alloc(sink->arena, cap);
+    if (!buf) {
+        return -1;
+    }
+    if (sink->len) {
+        memcpy(buf, sink->buf, sink->len);
+    }
+    sink->buf = buf;
+    sink->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Hand the buffer of a callback sink to its function
+ */
+static inline int utf8_sink_flush(utf8_sink_t *sink)
+{
+    if (sink->fn && sink->len) {
+        if (sink->fn(sink->ctx, sink->buf, sink->len) != 0) {
+            return -1;
+        }
+        sink->flushed += sink->len;
+        sink->len = 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Make room in a callback sink by flushing its buffer
+ */
+static inline int utf8_sink_grow_callback(utf8_sink_t *sink, size_t need)
+{
+    if (need > sink->cap) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    return utf8_sink_flush(sink);
+}
+
+/**
+ * @brief Write to a file descriptor until all bytes are written
+ *
+ * @param ctx The file descriptor, stored as an intptr_t
+ */
+static inline int utf8_sink_write_fd(void *ctx, const unsigned char *p,
+                                     size_t n)
+{
+    int fd = (int)(intptr_t)ctx;
+
+    while (n) {
+        ssize_t nw = write(fd, p, n);
+
+        if (nw < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += nw;
+        n -= (size_t)nw;
+    }
+    return 0;
+}
+
+/**
+ * @brief Initialize a sink writing to a caller buffer
+ *
+ * @param sink Pointer to the sink
+ * @param buf Pointer to the buffer
+ * @param cap Size of the buffer
+ */
+static inline void utf8_sink_fixed(utf8_sink_t *sink, unsigned char *buf,
+                                   size_t cap)
+{
+    *sink = (utf8_sink_t){
+        .buf  = buf,
+        .cap  = buf ? cap : 0,
+        .grow = utf8_sink_grow_fixed,
+    };
+}
+
+/**
+ * @brief Initialize a sink building a buffer in an arena
+ *
+ * The buffer is allocated on the first write and freed with the arena.
+ *
+ * @param sink Pointer to the sink
+ * @param arena Pointer to an initialized arena
+ */
+static inline void utf8_sink_builder(utf8_sink_t *sink, utf8_arena_t *arena)
+{
+    *sink = (utf8_sink_t){
+        .grow  = utf8_sink_grow_builder,
+        .arena = arena,
+    };
+}
+
+/**
+ * @brief Initialize a sink handing a caller buffer to a function when full
+ *
+ * @param sink Pointer to the sink
+ * @param fn Function called with the bytes to output, returning 0 on success
+ * or -1 on failure (with errno set)
+ * @param ctx Context passed to fn
+ * @param buf Pointer to the buffer
+ * @param cap Size of the buffer (at least 4 bytes)
+ */
+static inline void utf8_sink_callback(utf8_sink_t *sink, utf8_sink_fn fn,
+                                      void *ctx, unsigned char *buf,
+                                      size_t cap)
+{
+    *sink = (utf8_sink_t){
+        .buf  = buf,
+        .cap  = buf ? cap : 0,
+        .grow = utf8_sink_grow_callback,
+        .fn   = fn,
+        .ctx  = ctx,
+    };
+}
+
+/**
+ * @brief Initialize a sink writing to a file descriptor through a buffer
+ *
+ * Call utf8_sink_flush() to write the bytes left in the buffer.
+ */
+static inline void utf8_sink_fd(utf8_sink_t *sink, int fd, unsigned char *buf,
+                                size_t cap)
+{
+    // the descriptor is the context itself, so the sink can be copied
+    utf8_sink_callback(sink, utf8_sink_write_fd, (void *)(intptr_t)fd, buf,
+                       cap);
+}
+
+/**
+ * @brief Get room for n bytes at the end of a sink
+ *
+ * The bytes are added to the output by advancing sink->len.
+ *
+ * @return Pointer to at least n writable bytes, or NULL on failure (and errno
+ * is set)
+ */
+static inline unsigned char *utf8_sink_reserve(utf8_sink_t *sink, size_t n)
+{
+    if (n > sink->cap - sink->len && sink->grow(sink, n) != 0) {
+        return NULL;
+    }
+    return sink->buf + sink->len;
+}
+
+/**
+ * @brief Append bytes to a sink
+ *
+ * @return 0 on success, or -1 on failure (and errno is set)
+ */
+static inline int utf8_sink_write(utf8_sink_t *sink, const unsigned char *p,
+                                  size_t n)
+{
+    if (n > sink->cap - sink->len) {
+        // large writes to a callback sink bypass the buffer
+        if (sink->fn && n > sink->cap) {
+            if (utf8_sink_flush(sink) != 0 || sink->fn(sink->ctx, p, n) != 0) {
+                return -1;
+            }
+            sink->flushed += n;
+            return 0;
+        }
+        if (sink->grow(sink, n) != 0) {
+            return -1;
+        }
+    }
+    if (n) {
+        memcpy(sink->buf + sink->len, p, n);
+        sink->len += n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the output of a builder or fixed sink as a NUL-terminated string
+ *
+ * Unused room of a builder is given back to its arena.
+ *
+ * @param sink Pointer to the sink
+ * @param len Pointer to a size_t that receives the length of the output, or
+ * NULL
+ *
+ * @return Pointer to the output, or NULL on failure (and errno is set)
+ */
+static inline unsigned char *utf8_sink_finish(utf8_sink_t *sink, size_t *len)
+{
+    utf8_arena_block_t *b = NULL;
+
+    if (sink->fn) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!utf8_sink_reserve(sink, 1)) {
+        return NULL;
+    }
+    sink->buf[sink->len] = '\0';
+    b                    = sink->arena ? sink->arena->head : NULL;
+    if (b && sink->buf + sink->cap == b->data + b->used) {
+        b->used -= sink->cap - sink->len - 1;
+        sink->cap = sink->len + 1;
+    }
+    if (len) {
+        *len = sink->len;
+    }
+    return sink->buf;
+}
+
+/**
+ * @brief Total number of bytes output by a sink
+ */
+static inline size_t utf8_sink_size(const utf8_sink_t *sink)
+{
+    return sink->flushed + sink->len;
+}
+
+/**
+ * @brief Check for an escaped byte U+DC80-U+DCFF (ED B2-B3 80-BF)
+ *
+ * @param s Pointer to a buffer
+ * @param n Number of bytes in the buffer
+ */
+static inline int utf8_is_surrogateescape(const unsigned char *s, size_t n)
+{
+    return n >= 3 && s[0] == 0xED && (s[1] & 0xFE) == 0xB2 &&
+           (s[2] & 0xC0) == 0x80;
+}
+
+// appends n bytes, returns SIZE_MAX from the calling transform on failure
+#define utf8_sink_put(sink, p, n)                                              \
+    do {                                                                       \
+        if (utf8_sink_write((sink), (p), (n)) != 0) {                          \
+            return SIZE_MAX;                                                   \
+        }                                                                      \
+    } while (0)
+
+/**
+ * @brief Replace each illegal byte sequence with U+FFFD, writing to a sink
+ *
+ * @param sink Pointer to the sink
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to the sink, or SIZE_MAX on failure
+ * (and errno is set to EINVAL if parameters are invalid, or by the sink)
+ */
+static inline size_t utf8_sanitize_sink(utf8_sink_t *sink,
+                                        const unsigned char *s, size_t len)
+{
+    size_t start = 0;
+    size_t pos   = 0;
+
+    if (!sink || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    start = utf8_sink_size(sink);
+
+    while (pos < len) {
+        size_t vlen   = utf8_validlen(s + pos, len - pos);
+        size_t illlen = 0;
+
+        utf8_sink_put(sink, s + pos, vlen);
+        pos += vlen;
+        if (pos < len) {
+            utf8nclen(s + pos, len - pos, &illlen);
+            utf8_sink_put(sink, (const unsigned char *)"\xEF\xBF\xBD", 3);
+            pos += illlen;
+        }
+    }
+    return utf8_sink_size(sink) - start;
+}
+
+/**
+ * @brief Escape illegal bytes as "\xNN" and backslashes as "\\", writing to
+ * a sink
+ *
+ * @param sink Pointer to the sink
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to the sink, or SIZE_MAX on failure
+ * (and errno is set to EINVAL if parameters are invalid, or by the sink)
+ */
+static inline size_t utf8_escape_sink(utf8_sink_t *sink,
+                                      const unsigned char *s, size_t len)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    size_t start            = 0;
+    size_t pos              = 0;
+
+    if (!sink || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    start = utf8_sink_size(sink);
+
+    while (pos < len) {
+        size_t vlen               = utf8_validlen(s + pos, len - pos);
+        const unsigned char *end  = s + pos + vlen;
+        const unsigned char *from = s + pos;
+        const unsigned char *bs   = NULL;
+        size_t illlen             = 0;
+
+        // copy the valid run, doubling each backslash
+        while ((bs = memchr(from, '\\', (size_t)(end - from)))) {
+            utf8_sink_put(sink, from, (size_t)(bs - from) + 1);
+            utf8_sink_put(sink, bs, 1);
+            from = bs + 1;
+        }
+        utf8_sink_put(sink, from, (size_t)(end - from));
+        pos += vlen;
+
+        if (pos < len) {
+            utf8nclen(s + pos, len - pos, &illlen);
+            for (size_t i = 0; i < illlen; i++) {
+                unsigned char c   = s[pos + i];
+                unsigned char *p = utf8_sink_reserve(sink, 4);
+
+                if (!p) {
+                    return SIZE_MAX;
+                }
+                p[0] = '\\';
+                p[1] = 'x';
+                p[2] = (unsigned char)hex[c >> 4];
+                p[3] = (unsigned char)hex[c & 0xF];
+                sink->len += 4;
+            }
+            pos += illlen;
+        }
+    }
+    return utf8_sink_size(sink) - start;
+}
+
+/**
+ * @brief Map illegal bytes to U+DC80-U+DCFF (PEP 383 surrogateescape),
+ * writing to a sink
+ *
+ * @param sink Pointer to the sink
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to the sink, or SIZE_MAX on failure
+ * (and errno is set to EINVAL if parameters are invalid, or by the sink)
+ */
+static inline size_t utf8_surrogateescape_decode_sink(utf8_sink_t *sink,
+                                                      const unsigned char *s,
+                                                      size_t len)
+{
+    size_t start = 0;
+    size_t pos   = 0;
+
+    if (!sink || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    start = utf8_sink_size(sink);
+
+    while (pos < len) {
+        size_t vlen   = utf8_validlen(s + pos, len - pos);
+        size_t illlen = 0;
+
+        utf8_sink_put(sink, s + pos, vlen);
+        pos += vlen;
+        if (pos < len) {
+            utf8nclen(s + pos, len - pos, &illlen);
+            for (size_t i = 0; i < illlen; i++) {
+                unsigned char c  = s[pos + i];
+                unsigned char *p = utf8_sink_reserve(sink, 3);
+
+                if (!p) {
+                    return SIZE_MAX;
+                }
+                // U+DC80-U+DCFF: ED B2-B3 80-BF
+                p[0] = 0xED;
+                p[1] = (unsigned char)(0xB2 | (c >> 6 & 0x1));
+                p[2] = (unsigned char)(0x80 | (c & 0x3F));
+                sink->len += 3;
+            }
+            pos += illlen;
+        }
+    }
+    return utf8_sink_size(sink) - start;
+}
+
+/**
+ * @brief Map U+DC80-U+DCFF back to the original bytes 80-FF, writing to a
+ * sink
+ *
+ * @param sink Pointer to the sink
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of bytes written to the sink, or SIZE_MAX on failure
+ * (and errno is set to EINVAL if parameters are invalid, to EILSEQ if the
+ * buffer contains an illegal byte sequence that is not an escaped byte, or
+ * by the sink)
+ */
+static inline size_t utf8_surrogateescape_encode_sink(utf8_sink_t *sink,
+                                                      const unsigned char *s,
+                                                      size_t len)
+{
+    size_t start = 0;
+    size_t pos   = 0;
+
+    if (!sink || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    start = utf8_sink_size(sink);
+
+    while (pos < len) {
+        size_t vlen = utf8_validlen(s + pos, len - pos);
+        unsigned char c;
+
+        utf8_sink_put(sink, s + pos, vlen);
+        pos += vlen;
+        if (pos < len) {
+            if (!utf8_is_surrogateescape(s + pos, len - pos)) {
+                errno = EILSEQ;
+                return SIZE_MAX;
+            }
+            c = (unsigned char)(0x80 | (s[pos + 1] & 0x1) << 6 |
+                                (s[pos + 2] & 0x3F));
+            utf8_sink_put(sink, &c, 1);
+            pos += 3;
+        }
+    }
+    return utf8_sink_size(sink) - start;
+}
+
+#undef utf8_sink_put
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8split_h
+#define utf8split_h
+
+#include "utf8valid.h"
+
+//
+// Splitting a buffer into slices for external parallel processing.
+//
+// utf8_split() cuts a buffer into roughly equal slices at character
+// boundaries. utf8_validate_range() validates one slice of a buffer that may
+// have been cut anywhere, without reading outside the slice, and reports the
+// partial characters at both of its ends; utf8_stitch() combines the results
+// of all slices into the result of the whole buffer.
+//
+
+typedef struct {
+    size_t start;
+    size_t end;
+    // number of continuation bytes at the start that belong to a character
+    // of the previous slices (0-3)
+    size_t head;
+    // number of bytes at the end of a character that continues in the next
+    // slices (0-3)
+    size_t tail;
+    // offset of the first illegal byte sequence between head and tail, or
+    // end if there is none
+    size_t illpos;
+} utf8_range_t;
+
+/**
+ * @brief Move an offset forward to the start of a character
+ *
+ * At most 3 bytes are inspected; an offset that is followed by more
+ * continuation bytes is in an illegal byte sequence anyway.
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param pos Offset to move
+ *
+ * @return The offset of the first byte at or after pos that is not a
+ * continuation byte, or pos + 3, or len
+ */
+static inline size_t utf8_boundary(const unsigned char *s, size_t len,
+                                   size_t pos)
+{
+    for (int i = 0; i < 3 && pos < len && (s[pos] & 0xC0) == 0x80; i++) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * @brief Cut a buffer into slices at character boundaries
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param n Number of slices
+ * @param offsets Pointer to an array of n + 1 offsets that receives the
+ * slices; slice i is [offsets[i], offsets[i + 1]), and some slices may be
+ * empty if the buffer is short
+ *
+ * @return n, or SIZE_MAX if parameters are invalid (and errno is set to
+ * EINVAL)
+ */
+static inline size_t utf8_split(const unsigned char *s, size_t len, size_t n,
+                                size_t *offsets)
+{
+    if ((!s && len) || !n || !offsets) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    offsets[0] = 0;
+    for (size_t i = 1; i < n; i++) {
+        // i * len / n without overflow
+        size_t pos = len / n * i + len % n * i / n;
+
+        pos        = utf8_boundary(s, len, pos);
+        offsets[i] = pos > offsets[i - 1] ? pos : offsets[i - 1];
+    }
+    offsets[n] = len;
+    return n;
+}
+
+/**
+ * @brief Validate a slice of a buffer independently of the other slices
+ *
+ * Only the bytes of the slice are read. Continuation bytes at the start of
+ * the slice and the beginning of a character at its end are not checked
+ * here but reported as head and tail, for utf8_stitch().
+ *
+ * @param s Pointer to the buffer
+ * @param start Offset of the slice
+ * @param end Offset of the end of the slice
+ * @param range Pointer to the result of the slice
+ *
+ * @return The offset of the first illegal byte sequence in the slice, or end
+ * if there is none, or SIZE_MAX if parameters are invalid (and errno is set
+ * to EINVAL)
+ */
+static inline size_t utf8_validate_range(const unsigned char *s, size_t start,
+                                         size_t end, utf8_range_t *range)
+{
+    size_t pos = start;
+
+    if ((!s && end) || start > end || !range) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    *range = (utf8_range_t){start, end, 0, 0, end};
+    // the first slice can not continue a character
+    if (start) {
+        range->head = utf8_boundary(s, end, start) - start;
+        pos += range->head;
+    }
+    pos += utf8_validlen(s + pos, end - pos);
+    if (pos < end) {
+        if (utf8_is_partial(s + pos, end - pos)) {
+            range->tail = end - pos;
+        } else {
+            range->illpos = pos;
+        }
+    }
+    return range->illpos;
+}
+
+/**
+ * @brief Combine the results of consecutive slices
+ *
+ * @param s Pointer to the buffer
+ * @param ranges Pointer to the results of utf8_validate_range() for
+ * consecutive slices that start at offset 0
+ * @param n Number of slices
+ *
+ * @return The offset of the first illegal byte sequence, or the end of the
+ * last slice if the slices are valid, or SIZE_MAX if parameters are invalid
+ * (and errno is set to EINVAL)
+ */
+static inline size_t utf8_stitch(const unsigned char *s,
+                                 const utf8_range_t *ranges, size_t n)
+{
+    // a character that continues across slices
+    size_t cut   = 0;
+    size_t npart = 0;
+
+    if (!s || !ranges || !n) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const utf8_range_t *r = &ranges[i];
+
+        if (r->head && !npart) {
+            // continuation bytes without a first byte
+            return r->start;
+        } else if (npart) {
+            size_t total  = npart + r->head;
+            size_t illlen = 0;
+            size_t clen   = utf8nclen(s + cut, total, &illlen);
+
+            if (r->head == r->end - r->start && clen != total &&
+                utf8_is_partial(s + cut, total)) {
+                // the slice is a part of the character
+                npart = total;
+                continue;
+            } else if (clen != total) {
+                return clen ? cut + clen : cut;
+            }
+            npart = 0;
+        }
+        if (r->illpos < r->end) {
+            return r->illpos;
+        } else if (r->tail) {
+            cut   = r->end - r->tail;
+            npart = r->tail;
+        }
+    }
+    // the buffer ends inside a character
+    return npart ? cut : ranges[n - 1].end;
+}
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8str_h
+#define utf8str_h
+
+#include "utf8valid.h"
+
+//
+// A string handle that carries the result of its validation.
+//
+// All metadata is computed by a single pass on the first query and cached
+// in the handle, so passing the handle (instead of ptr and len) through
+// several layers avoids validating the same string again. The cache is
+// filled on demand; call utf8_str_scan() before sharing a handle between
+// threads.
+//
+// Illegal byte sequences count as one character and one UTF-16 code unit
+// each, as they would after being replaced with U+FFFD.
+//
+
+#define UTF8_STR_SCANNED 0x1
+#define UTF8_STR_VALID   0x2
+#define UTF8_STR_ASCII   0x4
+
+typedef struct {
+    const unsigned char *ptr;
+    size_t len;
+    unsigned int flags;
+    size_t nchar;
+    size_t nutf16;
+    size_t illpos;
+} utf8_str_t;
+
+/**
+ * @brief Initialize a string handle
+ *
+ * Nothing is scanned until the first query.
+ *
+ * @param str Pointer to the handle
+ * @param ptr Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ */
+static inline void utf8_str_init(utf8_str_t *str, const unsigned char *ptr,
+                                 size_t len)
+{
+    *str = (utf8_str_t){
+        .ptr = ptr,
+        .len = len,
+    };
+}
+
+/**
+ * @brief Compute and cache all metadata of a string handle
+ *
+ * The validity, ASCII-ness, character count and UTF-16 length are computed
+ * in one pass. Nothing is done if the handle has been scanned already.
+ *
+ * @param str Pointer to the handle
+ */
+static inline void utf8_str_scan(utf8_str_t *str)
+{
+    const unsigned char *s = str->ptr;
+    size_t len             = str->len;
+    size_t pos             = 0;
+    size_t nchar           = 0;
+    size_t nutf16          = 0;
+    size_t illpos          = len;
+
+    if (str->flags & UTF8_STR_SCANNED) {
+        return;
+    }
+
+    while (pos < len) {
+        size_t n      = utf8_asciilen(s + pos, len - pos);
+        size_t illlen = 0;
+        size_t clen   = 0;
+
+        nchar += n;
+        nutf16 += n;
+        pos += n;
+        if (pos == len) {
+            break;
+        }
+
+        clen = utf8nclen(s + pos, len - pos, &illlen);
+        if (!clen) {
+            if (illpos == len) {
+                illpos = pos;
+            }
+            clen = illlen;
+        }
+        nchar++;
+        // 4 byte characters are surrogate pairs in UTF-16
+        nutf16 += clen == 4 ? 2 : 1;
+        pos += clen;
+    }
+
+    str->nchar  = nchar;
+    str->nutf16 = nutf16;
+    str->illpos = illpos;
+    str->flags  = UTF8_STR_SCANNED;
+    if (illpos == len) {
+        str->flags |= UTF8_STR_VALID;
+        if (nchar == len) {
+            str->flags |= UTF8_STR_ASCII;
+        }
+    }
+}
+
+/**
+ * @brief Check if the string is valid UTF-8
+ */
+static inline int utf8_str_valid(utf8_str_t *str)
+{
+    utf8_str_scan(str);
+    return (str->flags & UTF8_STR_VALID) != 0;
+}
+
+/**
+ * @brief Check if the string consists of ASCII characters only
+ */
+static inline int utf8_str_ascii(utf8_str_t *str)
+{
+    utf8_str_scan(str);
+    return (str->flags & UTF8_STR_ASCII) != 0;
+}
+
+/**
+ * @brief Get the number of characters
+ */
+static inline size_t utf8_str_count(utf8_str_t *str)
+{
+    utf8_str_scan(str);
+    return str->nchar;
+}
+
+/**
+ * @brief Get the length in UTF-16 code units
+ */
+static inline size_t utf8_str_utf16len(utf8_str_t *str)
+{
+    utf8_str_scan(str);
+    return str->nutf16;
+}
+
+/**
+ * @brief Get the offset of the first illegal byte sequence, or the length of
+ * the string if it is valid
+ */
+static inline size_t utf8_str_illpos(utf8_str_t *str)
+{
+    utf8_str_scan(str);
+    return str->illpos;
+}
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8stream_h
+#define utf8stream_h
+
+#include "utf8valid.h"
+
+//
+// Streaming U+FFFD replacement.
+//
+// The input arrives in chunks of any size, and a character or an illegal
+// byte sequence may be cut off at the end of a chunk. The state keeps the
+// bytes of a cut off sequence until the next chunk decides it, so the
+// concatenated output is exactly the output of utf8_sanitize() for the
+// concatenated input, however the input is split.
+//
+
+typedef struct {
+    // bytes of a sequence that may continue in the next chunk
+    unsigned char pend[4];
+    size_t npend;
+    // 1 if an illegal byte sequence that has already been replaced may
+    // continue in the next chunk
+    int skip;
+} utf8_stream_t;
+
+/**
+ * @brief Initialize a stream state
+ */
+static inline void utf8_stream_init(utf8_stream_t *st)
+{
+    *st = (utf8_stream_t){0};
+}
+
+/**
+ * @brief Check whether the last chunk ended at a character boundary
+ *
+ * @return 1 if nothing of the last chunk is held back or continues into the
+ * next chunk
+ */
+static inline int utf8_stream_clean(const utf8_stream_t *st)
+{
+    return !st->npend && !st->skip;
+}
+
+/**
+ * @brief Compute the maximum output size of utf8_stream_sanitize()
+ *
+ * @param len Number of bytes in the chunk
+ */
+static inline size_t utf8_stream_sanitize_max(size_t len)
+{
+    // each byte may become U+FFFD, and so may a held back sequence
+    return len * 3 + 3;
+}
+
+/**
+ * @brief Get the maximum length of an illegal byte sequence
+ *
+ * @param c The first byte of the sequence
+ *
+ * @return The length of the longest sequence that starts with c, or
+ * SIZE_MAX if c does not start a sequence and the illegal bytes extend to the
+ * next first byte
+ */
+static inline size_t utf8_stream_seqmax(unsigned char c)
+{
+    if (c >= 0xC2 && c <= 0xDF) {
+        return 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        return 3;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        return 4;
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * @brief Replace each illegal byte sequence of a chunk with U+FFFD
+ *
+ * A sequence that is cut off at the end of the chunk is held back in the
+ * state and written by a later call.
+ *
+ * @param st Pointer to the stream state
+ * @param dst Pointer to a buffer of at least utf8_stream_sanitize_max(len)
+ * bytes
+ * @param s Pointer to the chunk
+ * @param len Number of bytes in the chunk
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_stream_sanitize(utf8_stream_t *st,
+                                          unsigned char *dst,
+                                          const unsigned char *s, size_t len)
+{
+    unsigned char *p = dst;
+    size_t pos       = 0;
+
+    if (!st || !dst || (!s && len)) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+#define is_utf8firstb(c)                                                       \
+    ((c) <= 0x7F || ((c) >= 0xC2 && (c) <= 0xF4))
+
+    // the rest of an illegal byte sequence of the previous chunks
+    if (st->skip) {
+        while (pos < len && !is_utf8firstb(s[pos])) {
+            pos++;
+        }
+        if (pos == len) {
+            return 0;
+        }
+        st->skip = 0;
+    }
+
+#undef is_utf8firstb
+
+    // a sequence held back from the previous chunks
+    if (st->npend) {
+        unsigned char seq[8];
+        size_t n      = len < 4 ? len : 4;
+        size_t clen   = 0;
+        size_t illlen = 0;
+
+        memcpy(seq, st->pend, st->npend);
+        memcpy(seq + st->npend, s, n);
+        n += st->npend;
+        clen = utf8nclen(seq, n, &illlen);
+        if (!clen && illlen == n && illlen < utf8_stream_seqmax(seq[0])) {
+            // still cut off
+            memcpy(st->pend, seq, n);
+            st->npend = n;
+            return 0;
+        } else if (clen) {
+            memcpy(p, seq, clen);
+            p += clen;
+            pos = clen - st->npend;
+        } else {
+            memcpy(p, "\xEF\xBF\xBD", 3);
+            p += 3;
+            pos = illlen - st->npend;
+        }
+        st->npend = 0;
+    }
+
+    while (pos < len) {
+        size_t vlen   = utf8_validlen(s + pos, len - pos);
+        size_t illlen = 0;
+        size_t max    = 0;
+
+        memcpy(p, s + pos, vlen);
+        p += vlen;
+        pos += vlen;
+        if (pos == len) {
+            break;
+        }
+
+        utf8nclen(s + pos, len - pos, &illlen);
+        max = utf8_stream_seqmax(s[pos]);
+        if (pos + illlen == len && illlen < max) {
+            // cut off by the end of the chunk
+            if (max == SIZE_MAX) {
+                memcpy(p, "\xEF\xBF\xBD", 3);
+                p += 3;
+                st->skip = 1;
+            } else {
+                memcpy(st->pend, s + pos, illlen);
+                st->npend = illlen;
+            }
+            break;
+        }
+        memcpy(p, "\xEF\xBF\xBD", 3);
+        p += 3;
+        pos += illlen;
+    }
+    return (size_t)(p - dst);
+}
+
+/**
+ * @brief Finish a stream at the end of the input
+ *
+ * A sequence that is still held back is an illegal byte sequence and is
+ * replaced with U+FFFD.
+ *
+ * @param st Pointer to the stream state
+ * @param dst Pointer to a buffer of at least 3 bytes
+ *
+ * @return The number of bytes written to dst, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_stream_finish(utf8_stream_t *st, unsigned char *dst)
+{
+    size_t n = 0;
+
+    if (!st || !dst) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+    if (st->npend) {
+        memcpy(dst, "\xEF\xBF\xBD", 3);
+        n = 3;
+    }
+    utf8_stream_init(st);
+    return n;
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8sub_h
+#define utf8sub_h
+
+#include "utf8clen.h"
+#include <stddef.h>
+#include <string.h>
+
+//
+// Character positions are found by counting lead bytes (any byte that is not
+// a continuation byte 80-BF), eight bytes at a time. Only the last word is
+// resolved byte by byte. For valid UTF-8 this is exactly the character
+// position; for invalid input every illegal byte that is not a continuation
+// byte counts as one character.
+//
+
+/**
+ * @brief Count the lead bytes in a 64-bit word
+ */
+static inline size_t utf8_nlead64(uint64_t v)
+{
+    // continuation byte: bit 7 set and bit 6 clear
+    uint64_t tail = v & ~v << 1 & UINT64_C(0x8080808080808080);
+
+#if defined(__GNUC__) || defined(__clang__)
+    return 8 - (size_t)__builtin_popcountll(tail);
+#else
+    tail >>= 7;
+    return 8 - (size_t)((tail * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/**
+ * @brief Count the characters of a UTF-8 buffer
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of characters, or SIZE_MAX if parameters are invalid
+ * (and errno is set to EINVAL)
+ */
+static inline size_t utf8_count(const unsigned char *s, size_t len)
+{
+    size_t n   = 0;
+    size_t pos = 0;
+
+    if (!s && len) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t v;
+        memcpy(&v, s + pos, 8);
+        n += utf8_nlead64(v);
+    }
+    for (; pos < len; pos++) {
+        n += (s[pos] & 0xC0) != 0x80;
+    }
+    return n;
+}
+
+/**
+ * @brief Find the byte offset of the character at index idx
+ *
+ * @return The byte offset, or len if the buffer has no more than idx
+ * characters
+ */
+static inline size_t utf8_offset(const unsigned char *s, size_t len,
+                                 size_t idx)
+{
+    size_t pos = 0;
+
+    // skip whole words that end before the target
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t v;
+        size_t n = 0;
+        memcpy(&v, s + pos, 8);
+        n = utf8_nlead64(v);
+        if (n > idx) {
+            break;
+        }
+        idx -= n;
+    }
+    for (; pos < len; pos++) {
+        if ((s[pos] & 0xC0) != 0x80) {
+            if (!idx) {
+                return pos;
+            }
+            idx--;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Find the byte offset of the n-th character from the end (n >= 1)
+ *
+ * @return The byte offset, or 0 if the buffer has fewer than n characters
+ */
+static inline size_t utf8_roffset(const unsigned char *s, size_t len,
+                                  size_t n)
+{
+    size_t pos = len;
+
+    // skip whole words that start after the target
+    for (; pos >= 8; pos -= 8) {
+        uint64_t v;
+        size_t nlead = 0;
+        memcpy(&v, s + pos - 8, 8);
+        nlead = utf8_nlead64(v);
+        if (nlead >= n) {
+            break;
+        }
+        n -= nlead;
+    }
+    while (pos > 0) {
+        pos--;
+        if ((s[pos] & 0xC0) != 0x80 && !--n) {
+            return pos;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the byte range of the characters [start, start + count)
+ *
+ * This implements the SQL SUBSTRING/LEFT/RIGHT family with 0-based character
+ * positions:
+ *
+ *  SUBSTRING(s, start + 1, count) = utf8_sub(s, len, start, count, &sublen)
+ *  LEFT(s, n)                     = utf8_sub(s, len, 0, n, &sublen)
+ *  RIGHT(s, n)                    = utf8_sub(s, len, -n, n, &sublen)
+ *
+ * A negative start is counted from the end of the string (-1 is the last
+ * character) by scanning backward. Positions outside of the string are
+ * clamped to its bounds. Pass SIZE_MAX as count to take the rest of the
+ * string.
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ * @param start Index of the first character
+ * @param count Number of characters
+ * @param sublen Pointer to a size_t that will receive the byte length of the
+ * substring
+ *
+ * @return The byte offset of the substring, or SIZE_MAX if parameters are
+ * invalid (and errno is set to EINVAL)
+ */
+static inline size_t utf8_sub(const unsigned char *s, size_t len,
+                              ptrdiff_t start, size_t count, size_t *sublen)
+{
+    size_t head = 0;
+
+    if ((!s && len) || !sublen) {
+        errno = EINVAL;
+        return SIZE_MAX;
+    }
+
+    if (start >= 0) {
+        head = utf8_offset(s, len, (size_t)start);
+    } else {
+        head = utf8_roffset(s, len, (size_t)(-(start + 1)) + 1);
+    }
+    *sublen = utf8_offset(s + head, len - head, count);
+    return head;
+}
+
+#endif
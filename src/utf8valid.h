@@ -0,0 +1,92 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef utf8valid_h
+#define utf8valid_h
+
+#include "utf8clen.h"
+#include <string.h>
+
+/**
+ * @brief Count the leading ASCII bytes of a buffer
+ *
+ * This function scans the buffer eight bytes at a time and returns the number
+ * of leading bytes in the range 00-7F.
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The number of leading ASCII bytes (0-len)
+ */
+static inline size_t utf8_asciilen(const unsigned char *s, size_t len)
+{
+    size_t pos = 0;
+
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t v;
+        memcpy(&v, s + pos, 8);
+        if (v & UINT64_C(0x8080808080808080)) {
+            break;
+        }
+    }
+    while (pos < len && s[pos] <= 0x7F) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * @brief Determine the length of the longest valid UTF-8 prefix of a buffer
+ *
+ * This function skips ASCII runs with utf8_asciilen() and checks all other
+ * characters with utf8nclen(), so it accepts exactly the sequences accepted
+ * by utf8clen().
+ *
+ * @param s Pointer to a buffer
+ * @param len Number of bytes in the buffer
+ *
+ * @return The offset of the first illegal byte sequence, or len if the whole
+ * buffer is valid
+ */
+static inline size_t utf8_validlen(const unsigned char *s, size_t len)
+{
+    size_t pos = 0;
+
+    while (pos < len) {
+        size_t illlen = 0;
+        size_t clen   = 0;
+
+        pos += utf8_asciilen(s + pos, len - pos);
+        if (pos == len) {
+            break;
+        }
+        clen = utf8nclen(s + pos, len - pos, &illlen);
+        if (clen == 0) {
+            break;
+        }
+        pos += clen;
+    }
+    return pos;
+}
+
+#endif
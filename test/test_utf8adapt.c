@@ -0,0 +1,143 @@
+#include "../src/utf8adapt.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXLEN 600
+#define NRAND  5000
+
+// Test helper function: all kernels agree with utf8_validlen()
+static void test_case(const char *desc, const unsigned char *s, size_t len,
+                      int verbose)
+{
+    static const utf8_adapt_params_t tiny = {
+        .small = 0, .sample = 8, .ascii_pct = 100};
+    size_t expected = utf8_validlen(s, len);
+    size_t results[] = {
+        utf8_validlen_scalar(s, len),
+        utf8_validlen_dfa(s, len),
+        utf8_validlen_adaptive(s, len, NULL),
+        utf8_validlen_adaptive(s, len, &tiny),
+    };
+
+    for (size_t i = 0; i < sizeof(results) / sizeof(*results); i++) {
+        if (results[i] != expected) {
+            printf("FAIL: %s\n", desc);
+            printf("  Expected: %zu, got: %zu (kernel %zu)\n", expected,
+                   results[i], i);
+            exit(1);
+        }
+    }
+    if (verbose) {
+        printf("PASS: %s\n", desc);
+    }
+}
+
+static void test_str(const char *desc, const char *s)
+{
+    test_case(desc, (const unsigned char *)s, strlen(s), 1);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_validlen_adaptive(NULL, 1, NULL) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+    assert(utf8_validlen_adaptive(NULL, 0, NULL) == 0);
+    assert(utf8_validlen_dfa(NULL, 0) == 0);
+    printf("PASS: empty input\n");
+}
+
+// Test each row of Table 3-7 and its boundaries
+static void test_kernels(void)
+{
+    printf("\n=== Testing kernels ===\n");
+    test_str("ASCII", "plain ASCII text");
+    test_str("C2-DF 80-BF", "\xC2\x80\xDF\xBF");
+    test_str("E0 A0-BF 80-BF", "\xE0\xA0\x80\xE0\xBF\xBF");
+    test_str("E1-EC 80-BF 80-BF", "\xE1\x80\x80\xEC\xBF\xBF");
+    test_str("ED 80-9F 80-BF", "\xED\x80\x80\xED\x9F\xBF");
+    test_str("EE-EF 80-BF 80-BF", "\xEE\x80\x80\xEF\xBF\xBF");
+    test_str("F0 90-BF 80-BF 80-BF", "\xF0\x90\x80\x80\xF0\xBF\xBF\xBF");
+    test_str("F1-F3 80-BF 80-BF 80-BF", "\xF1\x80\x80\x80\xF3\xBF\xBF\xBF");
+    test_str("F4 80-8F 80-BF 80-BF", "\xF4\x80\x80\x80\xF4\x8F\xBF\xBF");
+    test_str("C0-C1 overlong", "ab\xC0\x80");
+    test_str("E0 overlong", "ab\xE0\x9F\xBF");
+    test_str("ED surrogate", "ab\xED\xA0\x80");
+    test_str("F0 overlong", "ab\xF0\x8F\xBF\xBF");
+    test_str("F4 above U+10FFFF", "ab\xF4\x90\x80\x80");
+    test_str("F5-FF", "ab\xF5\x80\x80\x80");
+    test_str("Stray continuation byte", "\xC3\xA9\x80");
+    test_str("Truncated at end", "caf\xC3");
+    test_str("Truncated before ASCII", "\xE3\x81" "a");
+}
+
+// Test random buffers of all mixes
+static void test_random(void)
+{
+    unsigned char s[MAXLEN];
+
+    printf("\n=== Testing random buffers ===\n");
+    srand(1);
+    for (int n = 0; n < NRAND; n++) {
+        size_t len    = (size_t)rand() % MAXLEN;
+        int ascii_pct = rand() % 101;
+
+        for (size_t i = 0; i < len; i++) {
+            s[i] = (unsigned char)(rand() % 100 < ascii_pct ? rand() % 128
+                                                            : rand() % 256);
+        }
+        test_case("random buffer", s, len, 0);
+        // valid buffers, to reach their ends
+        len = utf8_validlen(s, len);
+        test_case("random valid buffer", s, len, 0);
+    }
+    printf("PASS: %d random buffers\n", NRAND);
+}
+
+// Test the kernel choice
+static void test_choose(void)
+{
+    static const utf8_adapt_params_t params = {
+        .small = 8, .sample = 64, .ascii_pct = 25};
+    unsigned char s[256];
+
+    printf("\n=== Testing kernel choice ===\n");
+    memset(s, 'a', sizeof(s));
+    assert(utf8_adapt_choose(s, sizeof(s), NULL) == UTF8_KERNEL_ASCII);
+    printf("PASS: ASCII text\n");
+    for (size_t i = 0; i + 3 <= sizeof(s); i += 3) {
+        memcpy(s + i, "\xE3\x81\x82", 3);
+    }
+    assert(utf8_adapt_choose(s, sizeof(s), NULL) == UTF8_KERNEL_DFA);
+    printf("PASS: CJK text\n");
+
+    // one word in four is ASCII
+    for (size_t i = 0; i < sizeof(s); i += 32) {
+        memset(s + i, 'a', 8);
+    }
+    assert(utf8_adapt_choose(s, sizeof(s), NULL) == UTF8_KERNEL_DFA);
+    assert(utf8_adapt_choose(s, sizeof(s), &params) == UTF8_KERNEL_ASCII);
+    printf("PASS: thresholds\n");
+
+    assert(utf8_adapt_choose(s, 7, &params) == UTF8_KERNEL_DFA);
+    assert(utf8_adapt_choose((const unsigned char *)"abcdefgh\xC3\xA9", 10,
+                             NULL) == UTF8_KERNEL_ASCII);
+    printf("PASS: short buffers\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_kernels();
+    test_random();
+    test_choose();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include "../src/utf8class.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSET  20
+#define NRAND 20000
+
+// reference: decode and test the ranges
+static int in_ranges(const utf8_cprange_t *ranges, size_t n, uint32_t cp)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (cp >= ranges[i].lo && cp <= ranges[i].hi) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static size_t ref_match(const utf8_cprange_t *ranges, size_t n,
+                        const unsigned char *s, size_t len)
+{
+    uint32_t cp   = 0;
+    size_t illlen = 0;
+    size_t clen   = utf8_decode(s, len, &cp, &illlen);
+
+    return clen && in_ranges(ranges, n, cp) ? clen : 0;
+}
+
+// Test helper function: compare a class with its ranges on every code point
+// and on random byte sequences
+static void test_case(const char *desc, const utf8_cprange_t *ranges,
+                      size_t n, int verbose)
+{
+    utf8_class_t *cls = utf8_class_compile(ranges, n);
+    unsigned char s[8];
+
+    assert(cls);
+    for (uint32_t cp = 0; cp <= 0x10FFFF; cp++) {
+        size_t len = utf8_encode(s, cp);
+
+        if (len && utf8_class_match(cls, s, len) !=
+                       (in_ranges(ranges, n, cp) ? len : 0)) {
+            printf("FAIL: %s\n", desc);
+            printf("  U+%04X is %sin the class\n", (unsigned int)cp,
+                   in_ranges(ranges, n, cp) ? "" : "not ");
+            exit(1);
+        }
+    }
+    for (int i = 0; i < NRAND; i++) {
+        size_t len = 1 + (size_t)rand() % 4;
+
+        for (size_t j = 0; j < len; j++) {
+            s[j] = (unsigned char)(rand() % 4 ? 0x80 + rand() % 0x80
+                                              : rand() % 256);
+        }
+        if (utf8_class_match(cls, s, len) != ref_match(ranges, n, s, len)) {
+            printf("FAIL: %s\n", desc);
+            printf("  Random sequence of %zu bytes\n", len);
+            exit(1);
+        }
+    }
+    utf8_class_free(cls);
+    if (verbose) {
+        printf("PASS: %s\n", desc);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    static const utf8_cprange_t reversed[] = {{0x20, 0x10}};
+    static const utf8_cprange_t beyond[]   = {{0x10, 0x110000}};
+    utf8_class_t *cls                      = NULL;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(!utf8_class_compile(NULL, 1) && errno == EINVAL);
+    assert(!utf8_class_compile(reversed, 1) && errno == EINVAL);
+    assert(!utf8_class_compile(beyond, 1) && errno == EINVAL);
+    assert(utf8_class_find(NULL, (const unsigned char *)"a", 1, NULL) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: invalid parameters\n");
+
+    cls = utf8_class_compile(NULL, 0);
+    assert(cls && utf8_class_find(cls, (const unsigned char *)"abc", 3,
+                                  NULL) == 3);
+    utf8_class_free(cls);
+    printf("PASS: empty class\n");
+}
+
+// Test classes against every code point
+static void test_classes(void)
+{
+    static const utf8_cprange_t all[]      = {{0, 0x10FFFF}};
+    static const utf8_cprange_t cyrillic[] = {{0x400, 0x4FF}};
+    static const utf8_cprange_t han[]      = {
+        {0x2E80, 0x2E99}, {0x2E9B, 0x2EF3}, {0x2F00, 0x2FD5},
+        {0x3005, 0x3005}, {0x3007, 0x3007}, {0x3021, 0x3029},
+        {0x3038, 0x303B}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF},
+        {0xF900, 0xFA6D}, {0xFA70, 0xFAD9}, {0x20000, 0x2A6DF},
+        {0x2A700, 0x2B739}, {0x30000, 0x3134A},
+    };
+    static const utf8_cprange_t mixed[] = {
+        {'a', 'z'}, {0x7F, 0x80}, {0x7FF, 0x800}, {0xD700, 0xE100},
+        {0xFFFF, 0x10000}, {0x10FFF0, 0x10FFFF}, {'0', '9'}, {'x', 0x7F},
+    };
+    utf8_cprange_t ranges[8];
+
+    printf("\n=== Testing classes ===\n");
+    srand(1);
+    test_case("All code points", all, 1, 1);
+    test_case("U+0400-U+04FF", cyrillic, 1, 1);
+    test_case("Han", han, sizeof(han) / sizeof(*han), 1);
+    test_case("Ranges across length changes and surrogates", mixed,
+              sizeof(mixed) / sizeof(*mixed), 1);
+
+    for (int n = 0; n < NSET; n++) {
+        size_t nrange = 1 + (size_t)rand() % 8;
+
+        for (size_t i = 0; i < nrange; i++) {
+            uint32_t lo = (uint32_t)rand() % 0x110000;
+            uint32_t hi = lo + (uint32_t)rand() % (rand() % 2 ? 0x100 : 0x20000);
+
+            ranges[i] = (utf8_cprange_t){lo, hi > 0x10FFFF ? 0x10FFFF : hi};
+        }
+        test_case("random ranges", ranges, nrange, 0);
+    }
+    printf("PASS: %d random sets of ranges\n", NSET);
+}
+
+// Test searches with each prefilter against a character by character scan
+static void test_find(void)
+{
+    static const utf8_cprange_t hiragana[] = {{0x3040, 0x309F}};
+    static const utf8_cprange_t cyrillic[] = {{0x400, 0x4FF}};
+    static const utf8_cprange_t digits[]   = {{'0', '9'}, {0x660, 0x669}};
+    static const struct {
+        const char *name;
+        const utf8_cprange_t *ranges;
+        size_t n;
+        int lead;
+        int ascii;
+    } classes[] = {
+        {"one lead byte", hiragana, 1, 0xE3, 0},
+        {"no ASCII", cyrillic, 1, -1, 0},
+        {"ASCII and others", digits, 2, -1, 1},
+    };
+    static const char *pieces[] = {"a", " ", "7", "\xD0\x96", "\xD9\xA3",
+                                   "\xE3\x81\x82", "\xE3\x83\x86", "\xFF",
+                                   "\xE3\x81", "\x80", "\xF0\x9F\x98\x82"};
+    unsigned char s[256];
+
+    printf("\n=== Testing search ===\n");
+    for (size_t c = 0; c < sizeof(classes) / sizeof(*classes); c++) {
+        utf8_class_t *cls = utf8_class_compile(classes[c].ranges,
+                                               classes[c].n);
+
+        assert(cls && cls->lead == classes[c].lead &&
+               cls->ascii == classes[c].ascii);
+        for (int n = 0; n < 2000; n++) {
+            size_t len      = 0;
+            size_t expected = 0;
+            size_t mlen     = 0;
+            size_t found    = 0;
+
+            while (len < sizeof(s) - 4 && rand() % 64) {
+                const char *p = pieces[(size_t)rand() % 11];
+
+                memcpy(s + len, p, strlen(p));
+                len += strlen(p);
+            }
+            // character by character
+            while (expected < len) {
+                size_t illlen = 0;
+                size_t clen   = 0;
+
+                if (ref_match(classes[c].ranges, classes[c].n, s + expected,
+                              len - expected)) {
+                    break;
+                }
+                clen = utf8nclen(s + expected, len - expected, &illlen);
+                expected += clen ? clen : illlen;
+            }
+            found = utf8_class_find(cls, s, len, &mlen);
+            if (found != expected ||
+                (found < len &&
+                 mlen != ref_match(classes[c].ranges, classes[c].n, s + found,
+                                   len - found))) {
+                printf("FAIL: %s\n", classes[c].name);
+                printf("  Expected: %zu, got: %zu\n", expected, found);
+                exit(1);
+            }
+        }
+        utf8_class_free(cls);
+        printf("PASS: %s\n", classes[c].name);
+    }
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_classes();
+    test_find();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -213,6 +213,139 @@ static void test_special_cases(void)
               (const unsigned char *)"\xED\xBF\xBF", 0, 3);
 }
 
+// Test helper function for utf8nclen
+static void test_ncase(const char *desc, const unsigned char *input, size_t n,
+                       size_t expected_len, size_t expected_illlen)
+{
+    size_t illlen = 0;
+    size_t len    = utf8nclen(input, n, &illlen);
+
+    if (len == expected_len && illlen == expected_illlen) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected len: %zu, got: %zu\n", expected_len, len);
+        printf("  Expected illlen: %zu, got: %zu\n", expected_illlen, illlen);
+        exit(1);
+    }
+}
+
+// Test sized buffer variant
+static void test_sized_buffer(void)
+{
+    size_t illlen = 0;
+
+    printf("\n=== Testing utf8nclen ===\n");
+    assert(utf8nclen(NULL, 1, &illlen) == SIZE_MAX && errno == EINVAL);
+    printf("PASS: NULL string parameter\n");
+    assert(utf8nclen((const unsigned char *)"A", 0, &illlen) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: zero length parameter\n");
+    assert(utf8nclen((const unsigned char *)"A", 1, NULL) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL illlen parameter\n");
+
+    // Valid sequences that fit in the buffer
+    test_ncase("ASCII character 'A'", (const unsigned char *)"AB", 2, 1, 0);
+    test_ncase("2-byte: (é)", (const unsigned char *)"\xC3\xA9", 2, 2, 0);
+    test_ncase("3-byte: (あ)", (const unsigned char *)"\xE3\x81\x82", 3, 3, 0);
+    test_ncase("3-byte: E0 prefix", (const unsigned char *)"\xE0\xB8\x8B", 3,
+               3, 0);
+    test_ncase("3-byte: ED prefix", (const unsigned char *)"\xED\x9F\xBF", 3,
+               3, 0);
+    test_ncase("4-byte: F0 prefix", (const unsigned char *)"\xF0\x9F\x98\x82",
+               4, 4, 0);
+    test_ncase("4-byte: F1 prefix", (const unsigned char *)"\xF1\x80\x80\x80",
+               4, 4, 0);
+    test_ncase("4-byte: F4 prefix", (const unsigned char *)"\xF4\x8F\xBF\xBF",
+               4, 4, 0);
+
+    // Sequences cut off by the end of the buffer
+    test_ncase("2-byte cut after 1 byte", (const unsigned char *)"\xC3\xA9", 1,
+               0, 1);
+    test_ncase("3-byte cut after 2 bytes", (const unsigned char *)"\xE3\x81\x82",
+               2, 0, 2);
+    test_ncase("E0 cut after 2 bytes", (const unsigned char *)"\xE0\xB8\x8B", 2,
+               0, 2);
+    test_ncase("ED cut after 2 bytes", (const unsigned char *)"\xED\x9F\xBF", 2,
+               0, 2);
+    test_ncase("F0 cut after 3 bytes",
+               (const unsigned char *)"\xF0\x9F\x98\x82", 3, 0, 3);
+    test_ncase("F1 cut after 3 bytes",
+               (const unsigned char *)"\xF1\x80\x80\x80", 3, 0, 3);
+    test_ncase("F4 cut after 3 bytes",
+               (const unsigned char *)"\xF4\x8F\xBF\xBF", 3, 0, 3);
+    test_ncase("Continuation bytes cut by the buffer",
+               (const unsigned char *)"\x80\x80\x80", 2, 0, 2);
+
+    // Illegal sequences behave like utf8clen
+    test_ncase("Illegal surrogate pair (U+D800)",
+               (const unsigned char *)"\xED\xA0\x80", 3, 0, 3);
+    test_ncase("Illegal F4 with too high second byte",
+               (const unsigned char *)"\xF4\x90\x80\x80", 4, 0, 4);
+    test_ncase("Illegal run stops at NUL",
+               (const unsigned char *)"\x80\x80\x00\x80", 4, 0, 2);
+}
+
+// Test helper function for utf8clen_packed()
+static void test_pcase(const char *desc, const unsigned char *input, size_t n,
+                       uint32_t expected)
+{
+    uint32_t r = utf8clen_packed(input, n);
+
+    if (r == expected) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected: 0x%08X, got: 0x%08X\n", (unsigned int)expected,
+               (unsigned int)r);
+        exit(1);
+    }
+}
+
+// Test packed results
+static void test_packed_result(void)
+{
+    const unsigned char *text =
+        (const unsigned char *)"a\xC3\xA9\xE3\x81\x82\xF0\x9F\x98\x82";
+    const unsigned char *p    = text;
+    uint32_t all              = 0;
+
+    printf("\n=== Testing packed results ===\n");
+    test_pcase("NULL pointer", NULL, 1, UTF8CLEN_EINVAL);
+    test_pcase("Empty buffer", (const unsigned char *)"a", 0, UTF8CLEN_EINVAL);
+    test_pcase("ASCII character 'A'", (const unsigned char *)"A", 1, 1);
+    test_pcase("2-byte: (\xC3\xA9)", (const unsigned char *)"\xC3\xA9", 2, 2);
+    test_pcase("3-byte: (\xE3\x81\x82)",
+               (const unsigned char *)"\xE3\x81\x82", 3, 3);
+    test_pcase("4-byte: (\xF0\x9F\x98\x82)",
+               (const unsigned char *)"\xF0\x9F\x98\x82", 4, 4);
+    test_pcase("Illegal continuation bytes",
+               (const unsigned char *)"\x80\x80" "a", 3, UTF8CLEN_ILLEGAL | 2);
+    test_pcase("Illegal surrogate (U+D800)",
+               (const unsigned char *)"\xED\xA0\x80", 3, UTF8CLEN_ILLEGAL | 3);
+    test_pcase("Illegal 3-byte: E3 followed by ASCII",
+               (const unsigned char *)"\xE3\x81" "a", 3, UTF8CLEN_ILLEGAL | 2);
+    test_pcase("3-byte cut after 2 bytes",
+               (const unsigned char *)"\xE3\x81\x82", 2,
+               UTF8CLEN_ILLEGAL | UTF8CLEN_TRUNCATED | 2);
+    test_pcase("F0 cut after 1 byte", (const unsigned char *)"\xF0\x9F", 1,
+               UTF8CLEN_ILLEGAL | UTF8CLEN_TRUNCATED | 1);
+    test_pcase("Overlong E0 cut after 2 bytes",
+               (const unsigned char *)"\xE0\x80\x80", 2, UTF8CLEN_ILLEGAL | 2);
+    test_pcase("Surrogate cut after 2 bytes",
+               (const unsigned char *)"\xED\xA0\x80", 2, UTF8CLEN_ILLEGAL | 2);
+
+    // advance with the mask and check the batch once
+    while (*p) {
+        uint32_t r = utf8clen_packed(p, strlen((const char *)p));
+        all |= r;
+        p += r & UTF8CLEN_LEN_MASK;
+    }
+    assert(p == text + 10 && !(all & ~UTF8CLEN_LEN_MASK));
+    printf("PASS: batch of valid characters\n");
+}
+
 int main(void)
 {
     // Run all test categories
@@ -222,6 +355,8 @@ int main(void)
     test_3byte_sequences();
     test_4byte_sequences();
     test_special_cases();
+    test_sized_buffer();
+    test_packed_result();
 
     printf("\nAll tests passed successfully!\n");
     return 0;
@@ -0,0 +1,88 @@
+#include "../src/utf8cmp.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *a, const char *b,
+                      int expected)
+{
+    int rv = utf8_utf16cmp((const unsigned char *)a, strlen(a),
+                           (const unsigned char *)b, strlen(b));
+    int rrv = utf8_utf16cmp((const unsigned char *)b, strlen(b),
+                            (const unsigned char *)a, strlen(a));
+
+    rv  = (rv > 0) - (rv < 0);
+    rrv = (rrv > 0) - (rrv < 0);
+    if (rv == expected && rrv == -expected) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected: %d, got: %d (reversed: %d)\n", expected, rv, rrv);
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    printf("\n=== Testing parameter errors ===\n");
+    errno = 0;
+    assert(utf8_utf16cmp(NULL, 1, (const unsigned char *)"a", 1) == 0 &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+}
+
+// Test strings where UTF-8 and UTF-16 order agree
+static void test_same_order(void)
+{
+    printf("\n=== Testing strings in code point order ===\n");
+
+    test_case("Equal strings", "abc", "abc", 0);
+    test_case("Empty string", "", "a", -1);
+    test_case("Prefix sorts first", "abc", "abcd", -1);
+    test_case("ASCII difference", "abc", "abd", -1);
+    test_case("Difference after the first word", "0123456789a", "0123456789b",
+              -1);
+    // U+00E9 vs U+3042
+    test_case("2-byte before 3-byte", "\xC3\xA9", "\xE3\x81\x82", -1);
+    // U+D7FF vs U+10000
+    test_case("U+D7FF before supplementary", "\xED\x9F\xBF",
+              "\xF0\x90\x80\x80", -1);
+    // U+E000 vs U+FFFF
+    test_case("U+E000 before U+FFFF", "\xEE\x80\x80", "\xEF\xBF\xBF", -1);
+    // U+10000 vs U+10FFFF
+    test_case("Supplementary characters", "\xF0\x90\x80\x80",
+              "\xF4\x8F\xBF\xBF", -1);
+    // U+FF21 vs U+FF41
+    test_case("Difference in a continuation byte", "\xEF\xBC\xA1",
+              "\xEF\xBD\x81", -1);
+}
+
+// Test strings where UTF-16 order differs from code point order
+static void test_utf16_order(void)
+{
+    printf("\n=== Testing UTF-16 code unit order ===\n");
+
+    // U+10000 (D800 DC00) vs U+E000
+    test_case("Supplementary before U+E000", "\xF0\x90\x80\x80",
+              "\xEE\x80\x80", -1);
+    // U+1F602 (D83D DE02) vs U+FFFD
+    test_case("Emoji before U+FFFD", "x\xF0\x9F\x98\x82", "x\xEF\xBF\xBD", -1);
+    // U+10FFFF (DBFF DFFF) vs U+FF01
+    test_case("U+10FFFF before U+FF01", "\xF4\x8F\xBF\xBF", "\xEF\xBC\x81",
+              -1);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_same_order();
+    test_utf16_order();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
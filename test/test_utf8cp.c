@@ -0,0 +1,96 @@
+#include "../src/utf8cp.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *input, size_t n,
+                      uint32_t expected_cp, size_t expected_len)
+{
+    unsigned char buf[4];
+    uint32_t cp   = 0;
+    size_t illlen = 0;
+    size_t len =
+        utf8_decode((const unsigned char *)input, n, &cp, &illlen);
+
+    if (len == expected_len && cp == expected_cp &&
+        utf8_encode(buf, cp) == expected_len && memcmp(buf, input, len) == 0) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected len: %zu, got: %zu\n", expected_len, len);
+        printf("  Expected cp: U+%04X, got: U+%04X\n", (unsigned)expected_cp,
+               (unsigned)cp);
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    size_t illlen = 0;
+    uint32_t cp   = 0;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_decode((const unsigned char *)"a", 1, NULL, &illlen) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_decode(NULL, 1, &cp, &illlen) == SIZE_MAX && errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+}
+
+// Test decoding and encoding of valid characters
+static void test_valid(void)
+{
+    printf("\n=== Testing valid characters ===\n");
+
+    test_case("U+0000", "\0", 1, 0x0000, 1);
+    test_case("U+007F", "\x7F", 1, 0x007F, 1);
+    test_case("U+0080", "\xC2\x80", 2, 0x0080, 2);
+    test_case("U+07FF", "\xDF\xBF", 2, 0x07FF, 2);
+    test_case("U+0800", "\xE0\xA0\x80", 3, 0x0800, 3);
+    test_case("U+D7FF", "\xED\x9F\xBF", 3, 0xD7FF, 3);
+    test_case("U+E000", "\xEE\x80\x80", 3, 0xE000, 3);
+    test_case("U+FFFF", "\xEF\xBF\xBF", 3, 0xFFFF, 3);
+    test_case("U+10000", "\xF0\x90\x80\x80", 4, 0x10000, 4);
+    test_case("U+1F602", "\xF0\x9F\x98\x82", 4, 0x1F602, 4);
+    test_case("U+10FFFF", "\xF4\x8F\xBF\xBF", 4, 0x10FFFF, 4);
+}
+
+// Test illegal sequences and code points
+static void test_illegal(void)
+{
+    unsigned char buf[4];
+    uint32_t cp   = 0;
+    size_t illlen = 0;
+
+    printf("\n=== Testing illegal sequences ===\n");
+
+    assert(utf8_decode((const unsigned char *)"\xED\xA0\x80", 3, &cp,
+                       &illlen) == 0 &&
+           illlen == 3);
+    printf("PASS: surrogate sequence is not decoded\n");
+    assert(utf8_decode((const unsigned char *)"\xE3\x81", 2, &cp, &illlen) ==
+               0 &&
+           illlen == 2);
+    printf("PASS: truncated sequence is not decoded\n");
+
+    assert(utf8_encode(buf, 0xD800) == 0);
+    assert(utf8_encode(buf, 0xDFFF) == 0);
+    printf("PASS: surrogate code points are not encoded\n");
+    assert(utf8_encode(buf, 0x110000) == 0);
+    printf("PASS: code points beyond U+10FFFF are not encoded\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_valid();
+    test_illegal();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
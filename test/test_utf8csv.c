@@ -0,0 +1,158 @@
+#include "../src/utf8csv.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *input, unsigned char delim,
+                      size_t expected_consumed, size_t expected_nfields,
+                      const size_t *expected_fields, size_t expected_illpos)
+{
+    size_t fields[16];
+    size_t nfields = 0;
+    size_t illpos  = 0;
+    size_t consumed =
+        utf8_csv_row((const unsigned char *)input, strlen(input), delim,
+                     fields, 16, &nfields, &illpos);
+
+    if (consumed == expected_consumed && nfields == expected_nfields &&
+        illpos == expected_illpos &&
+        memcmp(fields, expected_fields, nfields * sizeof(size_t)) == 0) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected consumed: %zu, got: %zu\n", expected_consumed,
+               consumed);
+        printf("  Expected nfields: %zu, got: %zu\n", expected_nfields,
+               nfields);
+        printf("  Expected illpos: %zu, got: %zu\n", expected_illpos, illpos);
+        for (size_t i = 0; i < nfields && i < 16; i++) {
+            printf("  field %zu ends at %zu\n", i, fields[i]);
+        }
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    size_t fields[4];
+    size_t nfields = 0;
+    size_t illpos  = 0;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_csv_row(NULL, 1, ',', fields, 4, &nfields, &illpos) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_csv_row((const unsigned char *)"a", 1, ',', NULL, 4, &nfields,
+                        &illpos) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_csv_row((const unsigned char *)"a", 1, ',', fields, 4, NULL,
+                        &illpos) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+
+    assert(utf8_csv_row((const unsigned char *)"", 0, ',', fields, 4,
+                        &nfields, &illpos) == 0 &&
+           nfields == 0 && illpos == SIZE_MAX);
+    printf("PASS: empty input\n");
+}
+
+// Test unquoted rows
+static void test_plain_rows(void)
+{
+    printf("\n=== Testing unquoted rows ===\n");
+
+    test_case("Single field without newline", "abc", ',', 3, 1,
+              (const size_t[]){3}, SIZE_MAX);
+    test_case("Three fields", "a,bc,def\nnext", ',', 9, 3,
+              (const size_t[]){1, 4, 8}, SIZE_MAX);
+    test_case("CRLF line terminator", "a,b\r\nnext", ',', 5, 2,
+              (const size_t[]){1, 3}, SIZE_MAX);
+    test_case("Empty fields", ",,\n", ',', 3, 3, (const size_t[]){0, 1, 2},
+              SIZE_MAX);
+    test_case("Empty row", "\n", ',', 1, 1, (const size_t[]){0}, SIZE_MAX);
+    test_case("TSV row", "a,b\tc\n", '\t', 6, 2, (const size_t[]){3, 5},
+              SIZE_MAX);
+    test_case("Long fields across words",
+              "0123456789abcdef,0123456789abcdef\n", ',', 34, 2,
+              (const size_t[]){16, 33}, SIZE_MAX);
+}
+
+// Test quoted rows
+static void test_quoted_rows(void)
+{
+    printf("\n=== Testing quoted rows ===\n");
+
+    test_case("Quoted delimiter", "\"a,b\",c\n", ',', 8, 2,
+              (const size_t[]){5, 7}, SIZE_MAX);
+    test_case("Quoted newline", "\"a\nb\",c\nnext", ',', 8, 2,
+              (const size_t[]){5, 7}, SIZE_MAX);
+    test_case("Escaped quote", "\"a\"\",b\",c\n", ',', 10, 2,
+              (const size_t[]){7, 9}, SIZE_MAX);
+    test_case("Quote in the middle of a field is literal", "a\"b,c\n", ',', 6,
+              2, (const size_t[]){3, 5}, SIZE_MAX);
+    test_case("Long quoted field across words",
+              "\"0123456789,abcdef\n0123456789\",x\n", ',', 33, 2,
+              (const size_t[]){30, 32}, SIZE_MAX);
+}
+
+// Test UTF-8 validation of rows
+static void test_validation(void)
+{
+    printf("\n=== Testing UTF-8 validation ===\n");
+
+    test_case("Valid multi-byte fields", "\xE3\x81\x82,\xC3\xA9\n", ',', 7, 2,
+              (const size_t[]){3, 6}, SIZE_MAX);
+    test_case("Illegal byte in the second field", "abc,d\xFF" "e,f\n", ',', 10,
+              3, (const size_t[]){3, 7, 9}, 5);
+    test_case("Illegal byte in a quoted field", "\"a,\xC3\",b\n", ',', 8, 2,
+              (const size_t[]){5, 7}, 3);
+    test_case("Truncated sequence before the delimiter",
+              "0123456789\xE3\x81,x\n", ',', 15, 2,
+              (const size_t[]){12, 14}, 10);
+}
+
+// Test scanning of consecutive rows
+static void test_consecutive_rows(void)
+{
+    const char *data = "id,name\n1,\xE3\x81\x82\n2,b\xFF\n3,\"c\nd\"\n";
+    const unsigned char *s = (const unsigned char *)data;
+    size_t len             = strlen(data);
+    size_t bad[4];
+    size_t nbad = 0;
+    size_t nrow = 0;
+
+    printf("\n=== Testing consecutive rows ===\n");
+    while (len) {
+        size_t fields[4];
+        size_t nfields = 0;
+        size_t illpos  = 0;
+        size_t n = utf8_csv_row(s, len, ',', fields, 4, &nfields, &illpos);
+
+        assert(nfields == 2);
+        if (illpos != SIZE_MAX) {
+            bad[nbad++] = nrow;
+        }
+        nrow++;
+        s += n;
+        len -= n;
+    }
+    assert(nrow == 4 && nbad == 1 && bad[0] == 2);
+    printf("PASS: bad rows are reported without reparsing\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_plain_rows();
+    test_quoted_rows();
+    test_validation();
+    test_consecutive_rows();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
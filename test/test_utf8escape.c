@@ -0,0 +1,152 @@
+#include "../src/utf8escape.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef size_t (*transform_t)(unsigned char *, const unsigned char *, size_t);
+typedef size_t (*size_fn_t)(const unsigned char *, size_t);
+
+// Test helper function
+static void test_case(const char *desc, size_fn_t size_fn, transform_t fn,
+                      const char *input, size_t len, const char *expected,
+                      size_t expected_len)
+{
+    unsigned char buf[256];
+    size_t size = size_fn((const unsigned char *)input, len);
+    size_t n    = fn(buf, (const unsigned char *)input, len);
+
+    if (size == expected_len && n == expected_len &&
+        memcmp(buf, expected, expected_len) == 0) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected len: %zu, got size: %zu, len: %zu\n", expected_len,
+               size, n);
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    unsigned char buf[8];
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_sanitize_size(NULL, 1) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_sanitize(NULL, (const unsigned char *)"a", 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_escape_size(NULL, 1) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_escape(NULL, (const unsigned char *)"a", 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_escape(buf, NULL, 1) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_surrogateescape_decode_size(NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_surrogateescape_decode(NULL, buf, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_surrogateescape_encode_size(NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_surrogateescape_encode(buf, NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+
+    assert(utf8_escape(buf, NULL, 0) == 0);
+    printf("PASS: empty input\n");
+}
+
+// Test U+FFFD replacement
+static void test_sanitize(void)
+{
+    printf("\n=== Testing U+FFFD replacement ===\n");
+
+    test_case("Valid input is copied", utf8_sanitize_size, utf8_sanitize,
+              "abc\xE3\x81\x82", 6, "abc\xE3\x81\x82", 6);
+    test_case("Single illegal byte", utf8_sanitize_size, utf8_sanitize,
+              "a\xFF" "b", 3, "a\xEF\xBF\xBD" "b", 5);
+    test_case("Illegal run is replaced once", utf8_sanitize_size,
+              utf8_sanitize, "\xED\xA0\x80z", 4, "\xEF\xBF\xBDz", 4);
+    test_case("Consecutive illegal runs", utf8_sanitize_size, utf8_sanitize,
+              "\xC3\xC3", 2, "\xEF\xBF\xBD\xEF\xBF\xBD", 6);
+}
+
+// Test "\xNN" escaping
+static void test_escape(void)
+{
+    printf("\n=== Testing \\xNN escaping ===\n");
+
+    test_case("Valid input is copied", utf8_escape_size, utf8_escape,
+              "abc\xE3\x81\x82", 6, "abc\xE3\x81\x82", 6);
+    test_case("Backslash is doubled", utf8_escape_size, utf8_escape,
+              "a\\b\\", 4, "a\\\\b\\\\", 6);
+    test_case("Single illegal byte", utf8_escape_size, utf8_escape, "a\xFF" "b",
+              3, "a\\xFFb", 6);
+    test_case("Illegal run of several bytes", utf8_escape_size, utf8_escape,
+              "\xED\xA0\x80z", 4, "\\xED\\xA0\\x80z", 13);
+    test_case("Truncated sequence at the end", utf8_escape_size, utf8_escape,
+              "x\xE3\x81", 3, "x\\xE3\\x81", 9);
+}
+
+// Test PEP 383 surrogateescape
+static void test_surrogateescape(void)
+{
+    unsigned char buf[64];
+
+    printf("\n=== Testing surrogateescape ===\n");
+
+    test_case("Decode: valid input is copied", utf8_surrogateescape_decode_size,
+              utf8_surrogateescape_decode, "a\xC3\xA9", 3, "a\xC3\xA9", 3);
+    test_case("Decode: 0x80 to U+DC80", utf8_surrogateescape_decode_size,
+              utf8_surrogateescape_decode, "a\x80", 2, "a\xED\xB2\x80", 4);
+    test_case("Decode: 0xFF to U+DCFF", utf8_surrogateescape_decode_size,
+              utf8_surrogateescape_decode, "\xFF" "b", 2, "\xED\xB3\xBF" "b", 4);
+    test_case("Decode: illegal run", utf8_surrogateescape_decode_size,
+              utf8_surrogateescape_decode, "\xE3\x81", 2,
+              "\xED\xB3\xA3\xED\xB2\x81", 6);
+
+    test_case("Encode: valid input is copied", utf8_surrogateescape_encode_size,
+              utf8_surrogateescape_encode, "a\xC3\xA9", 3, "a\xC3\xA9", 3);
+    test_case("Encode: U+DC80 to 0x80", utf8_surrogateescape_encode_size,
+              utf8_surrogateescape_encode, "a\xED\xB2\x80", 4, "a\x80", 2);
+    test_case("Encode: U+DCFF to 0xFF", utf8_surrogateescape_encode_size,
+              utf8_surrogateescape_encode, "\xED\xB3\xBF" "b", 4, "\xFF" "b",
+              2);
+
+    // illegal sequences that are not escaped bytes
+    assert(utf8_surrogateescape_encode_size((const unsigned char *)"\xFF", 1) ==
+               SIZE_MAX &&
+           errno == EILSEQ);
+    assert(utf8_surrogateescape_encode(buf, (const unsigned char *)"\xED\xA0\x80",
+                                       3) == SIZE_MAX &&
+           errno == EILSEQ);
+    printf("PASS: Encode: unescaped illegal sequences are rejected\n");
+
+    // round trip of every byte value
+    {
+        unsigned char src[256];
+        unsigned char dec[256 * 3];
+        unsigned char enc[256];
+        size_t dlen = 0;
+
+        for (size_t i = 0; i < sizeof(src); i++) {
+            src[i] = (unsigned char)(255 - i);
+        }
+        dlen = utf8_surrogateescape_decode(dec, src, sizeof(src));
+        assert(utf8_surrogateescape_encode_size(dec, dlen) == sizeof(src));
+        assert(utf8_surrogateescape_encode(enc, dec, dlen) == sizeof(src));
+        assert(memcmp(enc, src, sizeof(src)) == 0);
+    }
+    printf("PASS: Round trip of all byte values\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_sanitize();
+    test_escape();
+    test_surrogateescape();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
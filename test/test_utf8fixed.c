@@ -0,0 +1,127 @@
+#include "../src/utf8fixed.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef int (*valid_fn_t)(const unsigned char *);
+typedef size_t (*len_fn_t)(const unsigned char *);
+
+// what a utf8clen() loop over a NUL-padded field accepts
+static int valid_loop(const unsigned char *s, size_t width, size_t *len)
+{
+    size_t pos = 0;
+
+    while (pos < width && s[pos]) {
+        size_t illlen = 0;
+        size_t clen   = utf8nclen(s + pos, width - pos, &illlen);
+
+        if (!clen) {
+            break;
+        }
+        pos += clen;
+    }
+    *len = utf8_fixed_len(s, width);
+    return pos == *len;
+}
+
+// Test helper function
+static void test_case(const char *desc, const char *input, size_t width,
+                      int expected, size_t expected_len)
+{
+    unsigned char field[64] = {0};
+    size_t len              = 0;
+    int valid               = 0;
+
+    memcpy(field, input, strlen(input) < width ? strlen(input) : width);
+    switch (width) {
+    case 8:
+        valid = utf8_fixed_valid8(field);
+        len   = utf8_fixed_len8(field);
+        break;
+    case 16:
+        valid = utf8_fixed_valid16(field);
+        len   = utf8_fixed_len16(field);
+        break;
+    case 32:
+        valid = utf8_fixed_valid32(field);
+        len   = utf8_fixed_len32(field);
+        break;
+    default:
+        valid = utf8_fixed_valid64(field);
+        len   = utf8_fixed_len64(field);
+    }
+
+    if (valid == expected && len == expected_len) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected valid: %d, got: %d\n", expected, valid);
+        printf("  Expected len: %zu, got: %zu\n", expected_len, len);
+        exit(1);
+    }
+}
+
+// Test keys of each width
+static void test_widths(void)
+{
+    printf("\n=== Testing fixed widths ===\n");
+    test_case("Empty key", "", 8, 1, 0);
+    test_case("ASCII key", "user:42", 8, 1, 7);
+    test_case("Full width ASCII key", "abcdefgh", 8, 1, 8);
+    test_case("Multibyte key", "\xE3\x81\x82\xE3\x81\x84", 8, 1, 6);
+    test_case("Character cut by the width", "abcdefg\xC3\xA9", 8, 0, 8);
+    test_case("Illegal byte", "key\xFF", 16, 0, 4);
+    test_case("Key of 16 bytes", "\xF0\x9F\x98\x82 emoji key", 16, 1, 14);
+    test_case("Surrogate in 32 bytes", "tenant/\xED\xA0\x80", 32, 0, 10);
+    test_case("Key of 64 bytes",
+              "orders.\xE6\xB3\xA8\xE6\x96\x87.region-0001.events", 64, 1,
+              32);
+}
+
+// Test that the results agree with a utf8clen() loop
+static void test_random(void)
+{
+    static const unsigned char alphabet[] = {
+        0x00, 'a', 'z', 0x80, 0xBF, 0xC3, 0xE3, 0xED, 0xF0, 0x9F, 0xA0,
+    };
+    static const size_t widths[] = {8, 16, 32, 64};
+    static const valid_fn_t valid_fns[] = {
+        utf8_fixed_valid8, utf8_fixed_valid16, utf8_fixed_valid32,
+        utf8_fixed_valid64};
+    static const len_fn_t len_fns[] = {utf8_fixed_len8, utf8_fixed_len16,
+                                       utf8_fixed_len32, utf8_fixed_len64};
+    unsigned char field[64];
+    unsigned int seed = 99;
+
+    printf("\n=== Testing agreement with a utf8clen loop ===\n");
+    for (size_t w = 0; w < sizeof(widths) / sizeof(*widths); w++) {
+        for (int i = 0; i < 100000; i++) {
+            size_t len = 0;
+            int valid  = 0;
+
+            for (size_t j = 0; j < widths[w]; j++) {
+                seed     = seed * 1103515245 + 12345;
+                // mostly ASCII, with a NUL padding now and then
+                field[j] = (seed >> 16) % 4
+                               ? (unsigned char)('a' + (seed >> 20) % 26)
+                               : alphabet[(seed >> 20) % sizeof(alphabet)];
+            }
+            valid = valid_loop(field, widths[w], &len);
+            if (valid_fns[w](field) != valid || len_fns[w](field) != len) {
+                printf("FAIL: Random keys of %zu bytes\n", widths[w]);
+                exit(1);
+            }
+        }
+        printf("PASS: Random keys of %zu bytes\n", widths[w]);
+    }
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_widths();
+    test_random();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/utf8glob.h"
+#include <assert.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NRAND 20000
+
+// Test helper function
+static void test_case(const char *desc, const char *pat, const char *s,
+                      int flags, int expected)
+{
+    utf8_glob_t *g = utf8_glob_compile((const unsigned char *)pat,
+                                       strlen(pat), flags);
+    int actual     = 0;
+
+    assert(g);
+    actual = utf8_glob_match(g, (const unsigned char *)s, strlen(s));
+    if (actual != expected) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected: %d, got: %d for \"%s\" against \"%s\"\n",
+               expected, actual, s, pat);
+        exit(1);
+    }
+    utf8_glob_free(g);
+    printf("PASS: %s\n", desc);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    utf8_glob_t *g = NULL;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(!utf8_glob_compile(NULL, 1, 0) && errno == EINVAL);
+    assert(!utf8_glob_compile((const unsigned char *)"a\xFF", 2, 0) &&
+           errno == EILSEQ);
+    assert(utf8_glob_match(NULL, (const unsigned char *)"a", 1) == -1 &&
+           errno == EINVAL);
+    printf("PASS: invalid parameters\n");
+
+    g = utf8_glob_compile(NULL, 0, 0);
+    assert(g && utf8_glob_match(g, NULL, 0) == 1 &&
+           utf8_glob_match(g, (const unsigned char *)"a", 1) == 0);
+    utf8_glob_free(g);
+    g = utf8_glob_compile((const unsigned char *)"*", 1, 0);
+    assert(g && utf8_glob_match(g, NULL, 0) == 1);
+    utf8_glob_free(g);
+    printf("PASS: empty pattern and empty string\n");
+}
+
+// Test wildcards on whole characters
+static void test_wildcards(void)
+{
+    printf("\n=== Testing wildcards ===\n");
+    test_case("Literal", "caf\xC3\xA9.txt", "caf\xC3\xA9.txt", 0, 1);
+    test_case("Literal mismatch", "caf\xC3\xA9.txt", "cafe.txt", 0, 0);
+    test_case("? matches a 2 byte character", "caf?.txt",
+              "caf\xC3\xA9.txt", 0, 1);
+    test_case("? matches a 4 byte character", "?", "\xF0\x9F\x98\x82", 0, 1);
+    test_case("? does not match two bytes of ASCII", "?", "ab", 0, 0);
+    test_case("Three ? for three CJK characters", "???.csv",
+              "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E.csv", 0, 1);
+    test_case("? matches an illegal byte sequence", "a?b", "a\xE3\x81" "b", 0,
+              1);
+    test_case("? matches one illegal byte sequence only", "a?b",
+              "a\xC3\xC3" "b", 0, 0);
+    test_case("* matches characters", "*.log", "\xE3\x83\xAD\xE3\x82\xB0.log",
+              0, 1);
+    test_case("* then ?", "*?\xC3\xA9", "\xC3\xA9\xC3\xA9", 0, 1);
+    test_case("Prefix and suffix", "data/*/*.csv", "data/x/y/z.csv", 0, 1);
+    test_case("Prefix and suffix overlap", "ab*ba", "aba", 0, 0);
+    test_case("Several stars", "*a*b*c*", "xxaxxbxxcxx", 0, 1);
+    test_case("Backtracking", "*ab*ab", "abababab", 0, 1);
+    test_case("Escaped star", "a\\*", "a*", 0, 1);
+    test_case("Escaped star mismatch", "a\\*", "ab", 0, 0);
+    test_case("PATHNAME: * does not match /", "data/*.csv", "data/x/y.csv",
+              UTF8_GLOB_PATHNAME, 0);
+    test_case("PATHNAME: ? does not match /", "a?b", "a/b",
+              UTF8_GLOB_PATHNAME, 0);
+    test_case("PATHNAME: literal /", "*/*", "x/y", UTF8_GLOB_PATHNAME, 1);
+}
+
+// Test bracket expressions with Unicode ranges
+static void test_sets(void)
+{
+    printf("\n=== Testing sets ===\n");
+    test_case("ASCII range", "[a-c]x", "bx", 0, 1);
+    test_case("Greek range", "[\xCE\xB1-\xCF\x89]", "\xCE\xBB", 0, 1);
+    test_case("Greek range mismatch", "[\xCE\xB1-\xCF\x89]", "l", 0, 0);
+    test_case("Hiragana range", "*[\xE3\x81\x81-\xE3\x82\x96].txt",
+              "x\xE3\x81\x82.txt", 0, 1);
+    test_case("Negated set", "[!a-z]", "\xC3\xA9", 0, 1);
+    test_case("Negated set with ^", "[^a-z]", "q", 0, 0);
+    test_case("Negated set matches an illegal byte", "[!a]", "\xFF", 0, 1);
+    test_case("Set does not match an illegal byte", "[\x01-\xF4\x8F\xBF\xBF]",
+              "\xFF", 0, 0);
+    test_case("] first is part of the set", "[]a]", "]", 0, 1);
+    test_case("Escaped ] in set", "[\\]]", "]", 0, 1);
+    test_case("Trailing - is part of the set", "[a-]", "-", 0, 1);
+    test_case("Unterminated [ is literal", "[ab", "[ab", 0, 1);
+    test_case("PATHNAME: negated set does not match /", "a[!x]b", "a/b",
+              UTF8_GLOB_PATHNAME, 0);
+}
+
+// Test ASCII patterns against fnmatch(), where bytes are characters
+static void test_fnmatch(void)
+{
+    static const char *pieces[] = {"a", "b", "*", "?", "[ab]", "[!a]",
+                                   "\\*", "/", "[a-c]"};
+    char pat[32];
+    char s[32];
+
+    printf("\n=== Testing against fnmatch ===\n");
+    srand(1);
+    for (int n = 0; n < NRAND; n++) {
+        size_t plen  = 0;
+        size_t slen  = (size_t)rand() % 12;
+        int pathname = rand() % 2;
+        utf8_glob_t *g;
+        int expected;
+
+        pat[0] = '\0';
+        for (int i = rand() % 6; i >= 0; i--) {
+            const char *p = pieces[rand() % 9];
+
+            memcpy(pat + plen, p, strlen(p) + 1);
+            plen += strlen(p);
+        }
+        for (size_t i = 0; i < slen; i++) {
+            s[i] = "ab*c/"[rand() % 5];
+        }
+        s[slen] = '\0';
+
+        g = utf8_glob_compile((const unsigned char *)pat, plen,
+                              pathname ? UTF8_GLOB_PATHNAME : 0);
+        assert(g);
+        expected = fnmatch(pat, s, pathname ? FNM_PATHNAME : 0) == 0;
+        if (utf8_glob_match(g, (const unsigned char *)s, slen) != expected) {
+            printf("FAIL: \"%s\" against \"%s\"\n", s, pat);
+            printf("  Expected: %d\n", expected);
+            exit(1);
+        }
+        utf8_glob_free(g);
+    }
+    printf("PASS: %d random patterns\n", NRAND);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_wildcards();
+    test_sets();
+    test_fnmatch();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "../src/utf8idna.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *unicode, const char *ascii)
+{
+    unsigned char buf[256];
+    size_t alen =
+        utf8_idna_to_ascii(buf, sizeof(buf), (const unsigned char *)unicode,
+                           strlen(unicode));
+
+    if (alen != strlen(ascii) || memcmp(buf, ascii, alen) != 0) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected ToASCII: %s, got: %.*s\n", ascii,
+               alen == SIZE_MAX ? 0 : (int)alen, buf);
+        exit(1);
+    }
+
+    size_t ulen = utf8_idna_to_unicode(
+        buf, sizeof(buf), (const unsigned char *)ascii, strlen(ascii));
+    if (ulen != strlen(unicode) || memcmp(buf, unicode, ulen) != 0) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected ToUnicode: %s, got: %.*s\n", unicode,
+               ulen == SIZE_MAX ? 0 : (int)ulen, buf);
+        exit(1);
+    }
+    printf("PASS: %s\n", desc);
+}
+
+// Test helper function for failures
+static void test_error(const char *desc,
+                       size_t (*fn)(unsigned char *, size_t,
+                                    const unsigned char *, size_t),
+                       size_t dstlen, const char *input, int expected_errno)
+{
+    unsigned char buf[256];
+
+    errno = 0;
+    if (fn(buf, dstlen, (const unsigned char *)input, strlen(input)) ==
+            SIZE_MAX &&
+        errno == expected_errno) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected errno: %d, got: %d\n", expected_errno, errno);
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    unsigned char buf[8];
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_idna_to_ascii(NULL, 8, (const unsigned char *)"a", 1) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_idna_to_unicode(buf, 8, NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+    assert(utf8_idna_to_ascii(buf, 8, (const unsigned char *)"", 0) == 0);
+    printf("PASS: empty hostname\n");
+}
+
+// Test single labels (RFC 3492 and well-known examples)
+static void test_labels(void)
+{
+    printf("\n=== Testing labels ===\n");
+
+    test_case("ASCII label", "example", "example");
+    test_case("Latin-1 label", "b\xC3\xBC" "cher", "xn--bcher-kva");
+    test_case("German sharp s", "fa\xC3\x9F", "xn--fa-hia");
+    test_case("Greek label",
+              "\xCF\x80\xCE\xB1\xCF\x81\xCE\xAC\xCE\xB4\xCE\xB5\xCE\xB9\xCE\xB3"
+              "\xCE\xBC\xCE\xB1",
+              "xn--hxajbheg2az3al");
+    test_case("Japanese label", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E",
+              "xn--wgv71a119e");
+    test_case("Katakana and Kanji label",
+              "\xE3\x83\x89\xE3\x83\xA1\xE3\x82\xA4\xE3\x83\xB3\xE5\x90\x8D\xE4"
+              "\xBE\x8B",
+              "xn--eckwd4c7cu47r2wf");
+    test_case("Symbol only label", "\xE2\x98\x83", "xn--n3h");
+}
+
+// Test whole hostnames
+static void test_hostnames(void)
+{
+    printf("\n=== Testing hostnames ===\n");
+
+    test_case("ASCII hostname", "www.example.com", "www.example.com");
+    test_case("Mixed hostname", "www.m\xC3\xBC" "nchen.de",
+              "www.xn--mnchen-3ya.de");
+    test_case("Fully qualified hostname", "\xE2\x98\x83.example.",
+              "xn--n3h.example.");
+
+    {
+        unsigned char buf[64];
+        size_t len = utf8_idna_to_unicode(
+            buf, sizeof(buf), (const unsigned char *)"XN--BCHER-KVA.de", 16);
+        assert(len == 10 && memcmp(buf, "B\xC3\xBC" "CHER.de", len) == 0);
+        printf("PASS: upper case ACE prefix and digits\n");
+    }
+}
+
+// Test failures
+static void test_errors(void)
+{
+    printf("\n=== Testing errors ===\n");
+
+    test_error("ToASCII: invalid UTF-8", utf8_idna_to_ascii, 256,
+               "www.b\xFF.de", EILSEQ);
+    test_error("ToASCII: label too long", utf8_idna_to_ascii, 256,
+               "0123456789012345678901234567890123456789012345678901234567890"
+               "123",
+               EMSGSIZE);
+    test_error("ToASCII: output does not fit", utf8_idna_to_ascii, 8,
+               "b\xC3\xBC" "cher", ERANGE);
+    test_error("ToUnicode: invalid UTF-8", utf8_idna_to_unicode, 256,
+               "www.\xC3.de", EILSEQ);
+    test_error("ToUnicode: invalid digit", utf8_idna_to_unicode, 256,
+               "xn--bcher-kv!", EILSEQ);
+    test_error("ToUnicode: truncated Punycode", utf8_idna_to_unicode, 256,
+               "xn--bcher-kv", EILSEQ);
+    test_error("ToUnicode: non-ASCII basic code point", utf8_idna_to_unicode,
+               256, "xn--b\xC3\xBC-kva", EILSEQ);
+    test_error("ToUnicode: code point overflow", utf8_idna_to_unicode, 256,
+               "xn--99999999999", EILSEQ);
+    test_error("ToUnicode: output does not fit", utf8_idna_to_unicode, 4,
+               "xn--bcher-kva", ERANGE);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_labels();
+    test_hostnames();
+    test_errors();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
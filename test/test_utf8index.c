@@ -0,0 +1,259 @@
+#include "../src/utf8index.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXLEN 2048
+
+static unsigned char text[MAXLEN];
+static size_t textlen;
+
+// offsets of each character and line of text, computed byte by byte
+static size_t charpos[MAXLEN];
+static size_t nchar;
+static size_t linepos[MAXLEN];
+static size_t nline;
+
+static void make_text(int with_illegal)
+{
+    static const char *pieces[] = {
+        "hello ", "\xE3\x81\x82\xE3\x81\x84", "\n", "\xC3\xA9", "world\n",
+        "\xF0\x9F\x98\x82", "\xE4\xB8\xAD\xE6\x96\x87\n", "0123456789",
+        "\xFF\x80\x80", "\xED\xA0\x80",
+    };
+    size_t npiece = sizeof(pieces) / sizeof(*pieces) - (with_illegal ? 0 : 2);
+    unsigned int seed = 12345;
+
+    textlen = 0;
+    while (1) {
+        const char *p = NULL;
+        size_t len    = 0;
+
+        seed = seed * 1103515245 + 12345;
+        p    = pieces[(seed >> 16) % npiece];
+        len  = strlen(p);
+        if (textlen + len > MAXLEN - 16) {
+            break;
+        }
+        memcpy(text + textlen, p, len);
+        textlen += len;
+    }
+
+    nchar = 0;
+    nline = 0;
+    linepos[nline++] = 0;
+    for (size_t pos = 0; pos < textlen;) {
+        size_t illlen = 0;
+        size_t clen   = utf8nclen(text + pos, textlen - pos, &illlen);
+
+        charpos[nchar++] = pos;
+        for (size_t i = 0; i < (clen ? clen : illlen); i++) {
+            if (text[pos + i] == '\n') {
+                linepos[nline++] = pos + i + 1;
+            }
+        }
+        pos += clen ? clen : illlen;
+    }
+}
+
+// Test helper function
+static void test_case(const char *desc, size_t chunk_size, int with_illegal)
+{
+    static uint64_t buf[(sizeof(utf8_index_header_t) +
+                         MAXLEN * sizeof(utf8_index_chunk_t)) /
+                        8];
+    const utf8_index_header_t *hdr = NULL;
+    size_t size                    = 0;
+
+    make_text(with_illegal);
+    size = utf8_index_build(buf, sizeof(buf), text, textlen, chunk_size, 42);
+    assert(size == utf8_index_size(textlen, chunk_size));
+    hdr = utf8_index_open(buf, size, textlen, 42);
+    assert(hdr);
+
+    if (hdr->nchar != nchar || hdr->nline != nline - 1 ||
+        (hdr->ninvalid != 0) != with_illegal) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected nchar: %zu, got: %zu\n", nchar, (size_t)hdr->nchar);
+        printf("  Expected nline: %zu, got: %zu\n", nline - 1,
+               (size_t)hdr->nline);
+        exit(1);
+    }
+    for (size_t i = 0; i < nchar; i++) {
+        size_t pos = utf8_index_seek(hdr, text, i);
+        if (pos != charpos[i]) {
+            printf("FAIL: %s\n", desc);
+            printf("  Expected offset of character %zu: %zu, got: %zu\n", i,
+                   charpos[i], pos);
+            exit(1);
+        }
+    }
+    assert(utf8_index_seek(hdr, text, nchar) == textlen);
+    for (size_t i = 0; i < nline; i++) {
+        size_t pos = utf8_index_seek_line(hdr, text, i);
+        if (pos != linepos[i]) {
+            printf("FAIL: %s\n", desc);
+            printf("  Expected offset of line %zu: %zu, got: %zu\n", i,
+                   linepos[i], pos);
+            exit(1);
+        }
+    }
+    assert(utf8_index_seek_line(hdr, text, nline) == textlen);
+    printf("PASS: %s\n", desc);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    static uint64_t buf[64];
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_index_size(10, 0) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_index_build(buf, sizeof(buf), NULL, 10, 4, 0) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_index_build(buf, 8, (const unsigned char *)"abc", 3, 4, 0) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: invalid parameters\n");
+}
+
+// Test opening of an index
+static void test_open(void)
+{
+    static uint64_t buf[64];
+    const unsigned char *s = (const unsigned char *)"line\n\xE3\x81\x82\n";
+    size_t size = utf8_index_build(buf, sizeof(buf), s, 9, 4, 1000);
+
+    printf("\n=== Testing opening of an index ===\n");
+    assert(utf8_index_open(buf, size, 9, 1000));
+    printf("PASS: matching size and key\n");
+    assert(utf8_index_open(buf, size, 9, 1001) == NULL && errno == ESTALE);
+    assert(utf8_index_open(buf, size, 10, 1000) == NULL && errno == ESTALE);
+    printf("PASS: stale index is rejected\n");
+    assert(utf8_index_open(buf, size - 1, 9, 1000) == NULL && errno == EINVAL);
+    ((utf8_index_header_t *)buf)->magic ^= 1;
+    assert(utf8_index_open(buf, size, 9, 1000) == NULL && errno == EINVAL);
+    printf("PASS: malformed index is rejected\n");
+
+    size = utf8_index_build(buf, sizeof(buf), s, 0, 4, 0);
+    assert(size == sizeof(utf8_index_header_t));
+    assert(utf8_index_open(buf, size, 0, 0)->nchunk == 0);
+    assert(utf8_index_seek((const utf8_index_header_t *)buf, s, 0) == 0);
+    printf("PASS: empty file\n");
+}
+
+// Test seeking with various chunk sizes
+static void test_seek(void)
+{
+    static const size_t chunk_sizes[] = {1, 2, 3, 7, 16, 64, 4096};
+    char desc[64];
+
+    printf("\n=== Testing seeking ===\n");
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes); i++) {
+        snprintf(desc, sizeof(desc), "Valid text, chunk size %zu",
+                 chunk_sizes[i]);
+        test_case(desc, chunk_sizes[i], 0);
+        snprintf(desc, sizeof(desc), "Invalid text, chunk size %zu",
+                 chunk_sizes[i]);
+        test_case(desc, chunk_sizes[i], 1);
+    }
+}
+
+// Test updating of an index after changes of the file
+static void test_update(void)
+{
+    static const size_t chunk_sizes[] = {1, 2, 3, 5, 16, 64};
+    static const unsigned char bytes[] = {'a', '\n', 0x80, 0xBF, 0xC3,
+                                          0xE3, 0xED, 0xF0, 0xFF};
+    static uint64_t buf[(sizeof(utf8_index_header_t) +
+                         MAXLEN * sizeof(utf8_index_chunk_t)) /
+                        8];
+    static uint64_t expect[sizeof(buf) / 8];
+    unsigned int seed = 4321;
+    size_t nscan      = 0;
+    size_t size       = 0;
+
+    printf("\n=== Testing updating of an index ===\n");
+
+    // unchanged file
+    make_text(1);
+    size = utf8_index_build(buf, sizeof(buf), text, textlen, 16, 1);
+    assert(utf8_index_update(buf, sizeof(buf), text, textlen, 2, &nscan) ==
+               size &&
+           nscan == 0);
+    assert(utf8_index_open(buf, size, textlen, 2));
+    printf("PASS: unchanged file is not scanned\n");
+
+    // a single changed byte is scanned with its neighbouring chunks only
+    text[1000] = 'x';
+    assert(utf8_index_update(buf, sizeof(buf), text, textlen, 3, &nscan) ==
+               size &&
+           nscan <= 3);
+    utf8_index_build(expect, sizeof(expect), text, textlen, 16, 3);
+    assert(memcmp(buf, expect, size) == 0);
+    printf("PASS: changed byte is scanned with its neighbours only\n");
+
+    // a modified copy of the index is rejected
+    ((utf8_index_header_t *)buf)->version++;
+    assert(utf8_index_update(buf, sizeof(buf), text, textlen, 3, NULL) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: malformed index is rejected\n");
+
+    // random changes, appends and truncations give the same index as a
+    // rebuild
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes); i++) {
+        make_text(1);
+        utf8_index_build(buf, sizeof(buf), text, textlen, chunk_sizes[i], 0);
+        for (unsigned int round = 0; round < 200; round++) {
+            size_t pos = 0;
+
+            seed = seed * 1103515245 + 12345;
+            pos  = (seed >> 8) % textlen;
+            switch ((seed >> 4) % 4) {
+            case 0:
+                // append
+                if (textlen < MAXLEN - 8) {
+                    text[textlen++] = bytes[(seed >> 20) % sizeof(bytes)];
+                }
+                break;
+            case 1:
+                // truncate
+                if (textlen > 64) {
+                    textlen -= (seed >> 20) % 4;
+                }
+                break;
+            default:
+                // overwrite
+                text[pos] = bytes[(seed >> 20) % sizeof(bytes)];
+            }
+            size = utf8_index_update(buf, sizeof(buf), text, textlen, round,
+                                     NULL);
+            assert(size != SIZE_MAX);
+            assert(utf8_index_build(expect, sizeof(expect), text, textlen,
+                                    chunk_sizes[i], round) == size);
+            if (memcmp(buf, expect, size) != 0) {
+                printf("FAIL: random changes, chunk size %zu\n",
+                       chunk_sizes[i]);
+                printf("  Index differs from a rebuild after round %u\n",
+                       round);
+                exit(1);
+            }
+        }
+        printf("PASS: random changes, chunk size %zu\n", chunk_sizes[i]);
+    }
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_open();
+    test_seek();
+    test_update();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
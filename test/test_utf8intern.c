@@ -0,0 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/utf8intern.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NTHREAD 8
+#define NWORD   1000
+
+// Test helper function
+static void test_case(utf8_intern_t *tab, const char *desc, const char *input,
+                      size_t len, unsigned int expected_flags)
+{
+    const utf8_intern_entry_t *e =
+        utf8_intern(tab, (const unsigned char *)input, len);
+
+    if (e && e->len == len && memcmp(e->str, input, len) == 0 &&
+        e->str[len] == 0 && e->flags == expected_flags &&
+        utf8_intern(tab, (const unsigned char *)input, len) == e &&
+        utf8_intern_find(tab, (const unsigned char *)input, len) == e) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        if (e) {
+            printf("  Expected flags: %u, got: %u\n", expected_flags,
+                   e->flags);
+        }
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    utf8_intern_t *tab = utf8_intern_new(0);
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(tab && tab->nshard == 64);
+    assert(utf8_intern(NULL, (const unsigned char *)"a", 1) == NULL &&
+           errno == EINVAL);
+    assert(utf8_intern(tab, NULL, 1) == NULL && errno == EINVAL);
+    errno = 0;
+    assert(utf8_intern_find(NULL, (const unsigned char *)"a", 1) == NULL &&
+           errno == EINVAL);
+    errno = 0;
+    assert(utf8_intern_find(tab, NULL, 1) == NULL && errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+    utf8_intern_free(tab);
+    utf8_intern_free(NULL);
+}
+
+// Test interning of single strings
+static void test_intern(void)
+{
+    utf8_intern_t *tab = utf8_intern_new(3);
+
+    printf("\n=== Testing interning ===\n");
+    assert(tab->nshard == 4);
+
+    test_case(tab, "Empty string", "", 0,
+              UTF8_INTERN_VALID | UTF8_INTERN_ASCII);
+    test_case(tab, "ASCII string", "topic.orders", 12,
+              UTF8_INTERN_VALID | UTF8_INTERN_ASCII);
+    test_case(tab, "Non-ASCII string", "topic.\xE6\xB3\xA8\xE6\x96\x87", 12,
+              UTF8_INTERN_VALID);
+    test_case(tab, "Invalid string", "topic.\xFF", 7, 0);
+    test_case(tab, "Embedded NUL", "a\0b", 3,
+              UTF8_INTERN_VALID | UTF8_INTERN_ASCII);
+
+    assert(utf8_intern_find(tab, (const unsigned char *)"unknown", 7) == NULL);
+    printf("PASS: unknown strings are not found\n");
+    assert(utf8_intern_find(tab, (const unsigned char *)"topic.order", 11) ==
+           NULL);
+    printf("PASS: prefixes are distinct strings\n");
+
+    utf8_intern_free(tab);
+}
+
+// Test growing of the shards
+static void test_grow(void)
+{
+    utf8_intern_t *tab = utf8_intern_new(1);
+    const utf8_intern_entry_t *entries[NWORD];
+    char buf[32];
+
+    printf("\n=== Testing growing ===\n");
+    for (int i = 0; i < NWORD; i++) {
+        int len    = snprintf(buf, sizeof(buf), "tag-%d", i);
+        entries[i] = utf8_intern(tab, (const unsigned char *)buf, (size_t)len);
+        assert(entries[i]);
+    }
+    assert(tab->shards[0].nentry == NWORD);
+    assert(tab->shards[0].nbucket >= NWORD);
+    for (int i = 0; i < NWORD; i++) {
+        int len = snprintf(buf, sizeof(buf), "tag-%d", i);
+        assert(utf8_intern_find(tab, (const unsigned char *)buf,
+                                (size_t)len) == entries[i]);
+    }
+    printf("PASS: entries survive rehashing\n");
+    utf8_intern_free(tab);
+}
+
+typedef struct {
+    utf8_intern_t *tab;
+    const utf8_intern_entry_t **entries;
+    int offset;
+} worker_arg_t;
+
+static void *worker(void *arg)
+{
+    worker_arg_t *w = arg;
+    char buf[32];
+
+    for (int n = 0; n < NWORD; n++) {
+        int i   = (n + w->offset) % NWORD;
+        int len = snprintf(buf, sizeof(buf), "\xE3\x82\xBF\xE3\x82\xB0-%d", i);
+        w->entries[i] =
+            utf8_intern(w->tab, (const unsigned char *)buf, (size_t)len);
+    }
+    return NULL;
+}
+
+// Test interning from several threads
+static void test_threads(void)
+{
+    utf8_intern_t *tab = utf8_intern_new(8);
+    static const utf8_intern_entry_t *entries[NTHREAD][NWORD];
+    pthread_t threads[NTHREAD];
+    worker_arg_t args[NTHREAD];
+    size_t total = 0;
+
+    printf("\n=== Testing concurrent interning ===\n");
+    for (int t = 0; t < NTHREAD; t++) {
+        args[t] = (worker_arg_t){tab, entries[t], t * 97};
+        assert(pthread_create(&threads[t], NULL, worker, &args[t]) == 0);
+    }
+    for (int t = 0; t < NTHREAD; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    for (int i = 0; i < NWORD; i++) {
+        assert(entries[0][i] && entries[0][i]->flags == UTF8_INTERN_VALID);
+        for (int t = 1; t < NTHREAD; t++) {
+            assert(entries[t][i] == entries[0][i]);
+        }
+    }
+    for (size_t i = 0; i < tab->nshard; i++) {
+        total += tab->shards[i].nentry;
+    }
+    assert(total == NWORD);
+    printf("PASS: every thread gets the same entries\n");
+    utf8_intern_free(tab);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_intern();
+    test_grow();
+    test_threads();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
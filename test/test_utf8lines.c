@@ -0,0 +1,137 @@
+#include "../src/utf8lines.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXLEN 40000
+#define NRAND  200
+
+// Test helper function: compare with validating each line on its own
+static void test_case(const char *desc, const unsigned char *s, size_t len,
+                      int verbose)
+{
+    static const size_t nthreads[] = {1, 3, 8};
+
+    for (size_t t = 0; t < sizeof(nthreads) / sizeof(*nthreads); t++) {
+        utf8_lines_t res;
+        size_t nbad  = utf8_lines_validate(s, len, nthreads[t], &res);
+        size_t line  = 0;
+        size_t found = 0;
+
+        assert(nbad == res.nbad);
+        for (size_t pos = 0; pos < len; line++) {
+            const unsigned char *nl = memchr(s + pos, '\n', len - pos);
+            size_t end = nl ? (size_t)(nl - s) : len;
+            size_t vlen = utf8_validlen(s + pos, end - pos);
+            int bad     = vlen < end - pos;
+
+            if (bad) {
+                if (found >= res.nbad || res.bad[found].line != line ||
+                    res.bad[found].offset != pos + vlen) {
+                    printf("FAIL: %s\n", desc);
+                    printf("  Expected line %zu at offset %zu with %zu "
+                           "threads\n",
+                           line, pos + vlen, nthreads[t]);
+                    exit(1);
+                }
+                found++;
+            }
+            assert(utf8_lines_isbad(&res, line) == bad);
+            pos = end + 1;
+        }
+        if (found != res.nbad || line != res.nline) {
+            printf("FAIL: %s\n", desc);
+            printf("  Expected %zu bad lines of %zu, got %zu of %zu\n", found,
+                   line, res.nbad, res.nline);
+            exit(1);
+        }
+        assert(!utf8_lines_isbad(&res, res.nline));
+        utf8_lines_free(&res);
+    }
+    if (verbose) {
+        printf("PASS: %s\n", desc);
+    }
+}
+
+static void test_str(const char *desc, const char *s)
+{
+    test_case(desc, (const unsigned char *)s, strlen(s), 1);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    utf8_lines_t res;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_lines_validate(NULL, 1, 1, &res) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_lines_validate((const unsigned char *)"a", 1, 1, NULL) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+    assert(utf8_lines_validate(NULL, 0, 1, &res) == 0 && res.nline == 0);
+    utf8_lines_free(&res);
+    printf("PASS: empty input\n");
+}
+
+// Test short inputs
+static void test_lines(void)
+{
+    printf("\n=== Testing lines ===\n");
+    test_str("Valid lines", "{\"a\":1}\n{\"b\":\"\xC3\xA9\"}\n");
+    test_str("Last line without newline", "one\ntwo\nthree");
+    test_str("Empty lines", "\n\n\n");
+    test_str("Bad first and last line", "\xFF\nok\nbad \xC3");
+    test_str("Two illegal sequences in one line", "a\xFF b\xFE\nc\n");
+    test_str("Truncated character before newline", "abc\xE3\x81\nnext\n");
+    test_str("Long ASCII lines",
+             "0123456789abcdef0123456789abcdef\n0123456789abcdef\xC0\x80"
+             "0123456789abcdef\n");
+}
+
+// Test random NDJSON-like buffers split between threads
+static void test_random(void)
+{
+    static const char *pieces[] = {"{\"k\":", "\"v\"}", "\xE3\x81\x82",
+                                   "\xF0\x9F\x98\x82", "01234567", "\n",
+                                   "\n", "\xFF", "\xED\xA0\x80", "\xC3"};
+    unsigned char *s = malloc(MAXLEN);
+
+    printf("\n=== Testing random buffers ===\n");
+    assert(s);
+    srand(1);
+    for (int n = 0; n < NRAND; n++) {
+        size_t len  = 0;
+        size_t max  = (size_t)rand() % MAXLEN;
+        int bad_pct = rand() % 4;
+
+        while (len + 8 < max) {
+            size_t i = (size_t)rand() % 7;
+            size_t plen;
+
+            if (rand() % 100 < bad_pct) {
+                i = 7 + (size_t)rand() % 3;
+            }
+            plen = strlen(pieces[i]);
+            memcpy(s + len, pieces[i], plen);
+            len += plen;
+        }
+        test_case("random buffer", s, len, 0);
+    }
+    printf("PASS: %d random buffers\n", NRAND);
+    free(s);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_lines();
+    test_random();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
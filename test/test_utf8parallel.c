@@ -0,0 +1,162 @@
+#define _GNU_SOURCE
+#include "../src/utf8parallel.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFLEN (5 * UTF8_PARALLEL_STRIPE + 123)
+
+static unsigned char *buf;
+
+// fill the buffer with characters of 1 to 4 bytes
+static void fill(void)
+{
+    static const char *chars[] = {"a", "\xC3\xA9", "\xE3\x81\x82",
+                                  "\xF0\x9F\x98\x82"};
+    size_t pos                 = 0;
+
+    for (size_t i = 0; pos < BUFLEN; i++) {
+        const char *c = chars[i % 4];
+        size_t len    = strlen(c);
+
+        if (pos + len > BUFLEN) {
+            c   = "a";
+            len = 1;
+        }
+        memcpy(buf + pos, c, len);
+        pos += len;
+    }
+}
+
+// Test helper function
+static void test_case(const char *desc, size_t len)
+{
+    size_t expected = utf8_validlen(buf, len);
+
+    for (size_t nthread = 1; nthread <= 9; nthread += 4) {
+        size_t even = utf8_parallel_validlen(buf, len, nthread);
+        size_t numa = utf8_parallel_validlen_numa(buf, len, nthread);
+
+        if (even != expected || numa != expected) {
+            printf("FAIL: %s\n", desc);
+            printf("  Expected: %zu, got: %zu and %zu with %zu threads\n",
+                   expected, even, numa, nthread);
+            exit(1);
+        }
+    }
+    printf("PASS: %s\n", desc);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_parallel_validlen(NULL, 1, 2) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_parallel_validlen_numa(NULL, 1, 2) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+    assert(utf8_parallel_validlen(NULL, 0, 2) == 0);
+    assert(utf8_parallel_validlen_numa(NULL, 0, 2) == 0);
+    printf("PASS: empty input\n");
+}
+
+// Test valid input and illegal byte sequences at stripe boundaries
+static void test_validate(void)
+{
+    // boundaries of the even split between 1, 5 and 9 threads and of the
+    // 2 MiB stripes
+    static const size_t bounds[] = {
+        BUFLEN / 5, (BUFLEN + 4) / 5 * 2, (BUFLEN + 8) / 9 * 4,
+        UTF8_PARALLEL_STRIPE, UTF8_PARALLEL_STRIPE * 3,
+    };
+    char desc[80];
+
+    printf("\n=== Testing parallel validation ===\n");
+    fill();
+    test_case("Valid characters of all lengths", BUFLEN);
+    test_case("Short buffer", 7);
+    test_case("Buffer cut inside a character", BUFLEN - 2);
+
+    for (size_t i = 0; i < sizeof(bounds) / sizeof(*bounds); i++) {
+        for (size_t d = 0; d < 6; d++) {
+            size_t pos        = bounds[i] - 3 + d;
+            unsigned char old = buf[pos];
+
+            buf[pos] = 0xFF;
+            snprintf(desc, sizeof(desc), "Illegal byte at %zu", pos);
+            test_case(desc, BUFLEN);
+            buf[pos] = 0x80;
+            snprintf(desc, sizeof(desc), "Stray continuation byte at %zu",
+                     pos);
+            test_case(desc, BUFLEN);
+            buf[pos] = old;
+        }
+
+        // continuation bytes across the boundary
+        memset(buf + bounds[i] - 2, 0x80, 5);
+        snprintf(desc, sizeof(desc), "Continuation bytes across %zu",
+                 bounds[i]);
+        test_case(desc, BUFLEN);
+        fill();
+    }
+
+    // continuation bytes at the start of the buffer, where no stripe
+    // boundary is moved
+    for (size_t n = 1; n <= 4; n++) {
+        memset(buf, 0x80, n);
+        snprintf(desc, sizeof(desc), "%zu continuation bytes at offset 0", n);
+        test_case(desc, BUFLEN);
+        test_case(desc, 100);
+        fill();
+    }
+
+    // illegal byte sequences in two stripes
+    buf[UTF8_PARALLEL_STRIPE * 4 + 10] = 0xC0;
+    buf[UTF8_PARALLEL_STRIPE + 10]     = 0xC0;
+    test_case("First of two illegal byte sequences", BUFLEN);
+}
+
+// Test short random buffers split between many threads
+static void test_random(void)
+{
+    printf("\n=== Testing random buffers ===\n");
+    srand(1);
+    for (int n = 0; n < 2000; n++) {
+        size_t len = 1 + (size_t)rand() % 64;
+
+        for (size_t i = 0; i < len; i++) {
+            // mostly continuation bytes and lead bytes
+            buf[i] = (unsigned char)(rand() % 4 ? 0x80 + rand() % 0x80
+                                                : rand() % 256);
+        }
+        for (size_t nthread = 2; nthread <= 9; nthread++) {
+            size_t expected = utf8_validlen(buf, len);
+            size_t actual   = utf8_parallel_validlen(buf, len, nthread);
+
+            if (actual != expected) {
+                printf("FAIL: random buffer of %zu bytes\n", len);
+                printf("  Expected: %zu, got: %zu with %zu threads\n",
+                       expected, actual, nthread);
+                exit(1);
+            }
+        }
+    }
+    printf("PASS: 2000 random buffers\n");
+}
+
+int main(void)
+{
+    buf = malloc(BUFLEN);
+    assert(buf);
+
+    // Run all test categories
+    test_parameter_errors();
+    test_validate();
+    test_random();
+
+    free(buf);
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
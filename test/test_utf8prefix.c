@@ -0,0 +1,92 @@
+#include "../src/utf8prefix.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *a, const char *b,
+                      size_t expected_len, size_t expected_validlen)
+{
+    const unsigned char *sa = (const unsigned char *)a;
+    const unsigned char *sb = (const unsigned char *)b;
+    size_t len      = utf8_common_prefix(sa, strlen(a), sb, strlen(b));
+    size_t validlen = utf8_common_validprefix(sa, strlen(a), sb, strlen(b));
+
+    if (len == expected_len && validlen == expected_validlen) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected len: %zu, got: %zu\n", expected_len, len);
+        printf("  Expected validlen: %zu, got: %zu\n", expected_validlen,
+               validlen);
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_common_prefix(NULL, 1, (const unsigned char *)"a", 1) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_common_validprefix((const unsigned char *)"a", 1, NULL, 1) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+}
+
+// Test ASCII prefixes
+static void test_ascii(void)
+{
+    printf("\n=== Testing ASCII prefixes ===\n");
+
+    test_case("Equal strings", "/api/users", "/api/users", 10, 10);
+    test_case("Empty string", "", "/api", 0, 0);
+    test_case("One is a prefix of the other", "/api", "/api/users", 4, 4);
+    test_case("Mismatch in the second word", "/api/users/list",
+              "/api/users/item", 11, 11);
+}
+
+// Test prefixes that would split a character
+static void test_boundaries(void)
+{
+    printf("\n=== Testing character boundaries ===\n");
+
+    // あ = E3 81 82, い = E3 81 84
+    test_case("Mismatch in the last byte of a character",
+              "/\xE3\x81\x82", "/\xE3\x81\x84", 1, 1);
+    // é = C3 A9, ú = C3 BA
+    test_case("Mismatch in the second byte of a character",
+              "0123456789\xC3\xA9", "0123456789\xC3\xBA", 10, 10);
+    // 😂 = F0 9F 98 82, 😃 = F0 9F 98 83
+    test_case("Mismatch in the fourth byte of a character",
+              "key\xF0\x9F\x98\x82", "key\xF0\x9F\x98\x83", 3, 3);
+    test_case("Shorter string ends inside a character", "key\xE3\x81",
+              "key\xE3\x81\x82", 3, 3);
+    test_case("Mismatch after a shared character", "\xE3\x81\x82x",
+              "\xE3\x81\x82y", 3, 3);
+}
+
+// Test validation of the shared prefix
+static void test_validation(void)
+{
+    printf("\n=== Testing validation of the shared prefix ===\n");
+
+    test_case("Shared illegal byte", "ab\xFF" "cd", "ab\xFF" "ce", 4, 2);
+    test_case("Shared surrogate", "\xED\xA0\x80x", "\xED\xA0\x80y", 3, 0);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_ascii();
+    test_boundaries();
+    test_validation();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
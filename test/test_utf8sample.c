@@ -0,0 +1,193 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/utf8sample.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFLEN 100000
+
+static unsigned char buf[BUFLEN];
+
+// fill the buffer with characters of 1 to 4 bytes
+static void fill(void)
+{
+    static const char *chars[] = {"a", "\xC3\xA9", "\xE3\x81\x82",
+                                  "\xF0\x9F\x98\x82"};
+    size_t pos                 = 0;
+
+    for (size_t i = 0; pos < BUFLEN; i++) {
+        const char *c = chars[i % 7 % 4];
+        size_t len    = strlen(c);
+
+        if (pos + len > BUFLEN) {
+            c   = "a";
+            len = 1;
+        }
+        memcpy(buf + pos, c, len);
+        pos += len;
+    }
+}
+
+// Test helper function
+static void test_case(const char *desc, size_t nwindow, size_t window,
+                      uint64_t seed, size_t expected)
+{
+    utf8_sample_t res;
+    size_t nbad = utf8_sample(buf, BUFLEN, nwindow, window, seed, &res);
+
+    if (nbad != expected || res.nbad != nbad || res.nwindow != nwindow) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected %zu bad windows of %zu, got %zu of %zu\n",
+               expected, nwindow, nbad, res.nwindow);
+        exit(1);
+    }
+    printf("PASS: %s\n", desc);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    utf8_sample_t res;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_sample(NULL, 1, 1, 1, 0, &res) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_sample(buf, 1, 1, 1, 0, NULL) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_sample(buf, 1, 1, 0, 0, &res) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_sample_fd(-1, 1, 1, 0, &res) == SIZE_MAX && errno == EBADF);
+    printf("PASS: invalid parameters\n");
+    assert(utf8_sample(NULL, 0, 4, 16, 0, &res) == 0 && res.nwindow == 0);
+    assert(utf8_sample_bound(&res, 1.96, NULL) >= 1);
+    printf("PASS: empty input\n");
+}
+
+// Test sampling of valid and invalid buffers
+static void test_sample(void)
+{
+    utf8_sample_t res;
+
+    printf("\n=== Testing sampling ===\n");
+    fill();
+    test_case("Strided windows of a valid buffer", 100, 1000, 0, 0);
+    test_case("Random windows of a valid buffer", 500, 333, 42, 0);
+    test_case("Windows larger than the buffer", 3, BUFLEN * 2, 7, 0);
+
+    // strided windows that cover the whole buffer find every illegal byte
+    buf[12345] = 0xFF;
+    buf[98765] = 0x80;
+    assert(utf8_sample(buf, BUFLEN, 100, 1010, 0, &res) == 2);
+    assert(res.first_bad == utf8_validlen(buf, BUFLEN));
+    assert(res.nbytes >= BUFLEN);
+    printf("PASS: covering windows\n");
+
+    memset(buf, 0xFF, BUFLEN);
+    test_case("Invalid buffer", 50, 100, 3, 50);
+}
+
+// Test continuation bytes at the start of the input and of a window
+static void test_window_start(void)
+{
+    utf8_sample_t a;
+    utf8_sample_t b;
+    FILE *f = tmpfile();
+
+    printf("\n=== Testing window starts ===\n");
+    assert(f);
+    for (size_t n = 1; n <= 4; n++) {
+        fill();
+        memset(buf, 0x80, n);
+        rewind(f);
+        assert(fwrite(buf, 1, 4096, f) == 4096 && fflush(f) == 0);
+        assert(utf8_sample(buf, 4096, 16, 256, 0, &a) == 1);
+        assert(a.first_bad == 0);
+        assert(utf8_sample_fd(fileno(f), 16, 256, 0, &b) == 1);
+        assert(memcmp(&a, &b, sizeof(a)) == 0);
+    }
+    printf("PASS: continuation bytes at offset 0\n");
+
+    // windows of 100 bytes every 266 bytes; the fifth starts at 1064
+    fill();
+    memset(buf + 1062, 0x80, 5);
+    rewind(f);
+    assert(fwrite(buf, 1, 4096, f) == 4096 && fflush(f) == 0);
+    assert(utf8_sample(buf, 4096, 16, 100, 0, &a) == 1);
+    assert(a.first_bad >= 1061 && a.first_bad <= 1064);
+    assert(utf8_sample_fd(fileno(f), 16, 100, 0, &b) == 1);
+    assert(memcmp(&a, &b, sizeof(a)) == 0);
+    printf("PASS: continuation bytes before and at a window\n");
+
+    // a valid character that starts before the window
+    fill();
+    memcpy(buf + 1063, "\xF0\x9F\x98\x82", 4);
+    assert(utf8_sample(buf, 4096, 16, 100, 0, &a) == 0);
+    printf("PASS: character across the start of a window\n");
+    fclose(f);
+}
+
+// Test that results only depend on the seed, and that the file variant
+// samples the same windows
+static void test_reproducible(void)
+{
+    utf8_sample_t a;
+    utf8_sample_t b;
+    FILE *f = tmpfile();
+
+    printf("\n=== Testing reproducibility ===\n");
+    fill();
+    srand(3);
+    for (int i = 0; i < 200; i++) {
+        buf[(size_t)rand() % BUFLEN] = 0xC0;
+    }
+    assert(utf8_sample(buf, BUFLEN, 64, 512, 1234, &a) != SIZE_MAX);
+    assert(utf8_sample(buf, BUFLEN, 64, 512, 1234, &b) != SIZE_MAX);
+    assert(memcmp(&a, &b, sizeof(a)) == 0 && a.nbad > 0 && a.nbad < 64);
+    printf("PASS: same seed, same result\n");
+    assert(utf8_sample(buf, BUFLEN, 64, 512, 4321, &b) != SIZE_MAX);
+    assert(memcmp(&a, &b, sizeof(a)) != 0);
+    printf("PASS: other seed, other windows\n");
+
+    assert(f && fwrite(buf, 1, BUFLEN, f) == BUFLEN && fflush(f) == 0);
+    for (uint64_t seed = 0; seed < 5; seed++) {
+        assert(utf8_sample(buf, BUFLEN, 64, 700, seed, &a) != SIZE_MAX);
+        assert(utf8_sample_fd(fileno(f), 64, 700, seed, &b) == a.nbad);
+        assert(memcmp(&a, &b, sizeof(a)) == 0);
+    }
+    fclose(f);
+    printf("PASS: file and buffer samples match\n");
+}
+
+// Test the Wilson score interval
+static void test_bound(void)
+{
+    utf8_sample_t res = {.nwindow = 100, .nbad = 0};
+    double lower      = 0;
+    double upper      = utf8_sample_bound(&res, 1.96, &lower);
+
+    printf("\n=== Testing confidence bounds ===\n");
+    assert(lower <= 0 && upper > 0.036 && upper < 0.038);
+    printf("PASS: no bad windows\n");
+
+    res.nbad = 50;
+    upper    = utf8_sample_bound(&res, 1.96, &lower);
+    assert(lower > 0.40 && lower < 0.41 && upper > 0.59 && upper < 0.60);
+    printf("PASS: half bad windows\n");
+
+    res.nbad = 100;
+    upper    = utf8_sample_bound(&res, 1.96, &lower);
+    assert(upper > 0.999 && lower > 0.96 && lower < 0.97);
+    printf("PASS: all bad windows\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_sample();
+    test_window_start();
+    test_reproducible();
+    test_bound();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+#define _GNU_SOURCE
+#include "../src/utf8service.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NJOB     2000
+#define NCLIENT  4
+#define PAYLOAD  97
+
+static const char *inputs[] = {
+    "plain ASCII",
+    "caf\xC3\xA9 \xE3\x81\x82 \xF0\x9F\x98\x82",
+    "bad \xFF byte",
+    "truncated \xE3\x81",
+    "surrogate \xED\xA0\x80",
+    "",
+};
+
+// Test helper function
+static void test_case(const char *desc, size_t expected, size_t actual)
+{
+    if (expected != actual) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected: %zu, got: %zu\n", expected, actual);
+        exit(1);
+    }
+    printf("PASS: %s\n", desc);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(utf8_service_t *svc)
+{
+    utf8_service_job_t job;
+
+    printf("\n=== Testing parameter errors ===\n");
+    utf8_service_job_init(&job, NULL, 1, NULL, NULL);
+    assert(utf8_service_submit(svc, &job) == -1 && errno == EINVAL);
+    assert(utf8_service_submit(NULL, &job) == -1 && errno == EINVAL);
+    assert(utf8_service_submit(svc, NULL) == -1 && errno == EINVAL);
+    printf("PASS: invalid parameters\n");
+}
+
+// Test submit and wait, one job at a time
+static void test_wait(utf8_service_t *svc)
+{
+    printf("\n=== Testing submit and wait ===\n");
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); i++) {
+        const unsigned char *s = (const unsigned char *)inputs[i];
+        size_t len             = strlen(inputs[i]);
+        utf8_service_job_t job;
+        char desc[80];
+
+        utf8_service_job_init(&job, s, len, NULL, NULL);
+        assert(utf8_service_submit(svc, &job) == 0);
+        snprintf(desc, sizeof(desc), "Input %zu", i);
+        test_case(desc, utf8_validlen(s, len), utf8_service_wait(svc, &job));
+        assert(utf8_service_poll(&job));
+    }
+}
+
+static void count_done(utf8_service_job_t *job)
+{
+    size_t *ndone = job->udata;
+
+    if (job->illpos == utf8_validlen(job->s, job->len)) {
+        __atomic_add_fetch(ndone, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Test completion callbacks and draining on free
+static void test_callback(void)
+{
+    utf8_service_t *svc      = utf8_service_new(3);
+    utf8_service_job_t *jobs = calloc(NJOB, sizeof(*jobs));
+    size_t ndone             = 0;
+
+    printf("\n=== Testing callbacks ===\n");
+    assert(svc && jobs);
+    for (size_t i = 0; i < NJOB; i++) {
+        const char *s = inputs[i % (sizeof(inputs) / sizeof(*inputs))];
+
+        utf8_service_job_init(&jobs[i], (const unsigned char *)s, strlen(s),
+                              count_done, &ndone);
+        assert(utf8_service_submit(svc, &jobs[i]) == 0);
+    }
+    // all submitted jobs are done before the threads stop
+    utf8_service_free(svc);
+    test_case("Callbacks of all jobs", NJOB, ndone);
+    free(jobs);
+}
+
+typedef struct {
+    utf8_service_t *svc;
+    unsigned int seed;
+    size_t nfail;
+} client_t;
+
+// submit random payloads in bursts and wait for them
+static void *client_main(void *arg)
+{
+    client_t *c = arg;
+    unsigned char payloads[16][PAYLOAD];
+    utf8_service_job_t jobs[16];
+
+    for (size_t round = 0; round < NJOB / 16; round++) {
+        size_t n = 1 + (size_t)rand_r(&c->seed) % 16;
+
+        for (size_t i = 0; i < n; i++) {
+            size_t len = (size_t)rand_r(&c->seed) % PAYLOAD;
+
+            for (size_t j = 0; j < len; j++) {
+                // mostly ASCII, sometimes lead or continuation bytes
+                int r         = rand_r(&c->seed) % 64;
+                payloads[i][j] = (unsigned char)(r < 60 ? 'a' + r % 26
+                                                        : 0x80 + r * 17);
+            }
+            utf8_service_job_init(&jobs[i], payloads[i], len, NULL, NULL);
+            utf8_service_submit(c->svc, &jobs[i]);
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t illpos = utf8_service_wait(c->svc, &jobs[i]);
+
+            if (illpos != utf8_validlen(jobs[i].s, jobs[i].len)) {
+                c->nfail++;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Test concurrent submitters
+static void test_concurrent(void)
+{
+    utf8_service_t *svc = utf8_service_new(2);
+    pthread_t threads[NCLIENT];
+    client_t clients[NCLIENT];
+    size_t nfail = 0;
+
+    printf("\n=== Testing concurrent clients ===\n");
+    assert(svc);
+    for (unsigned int i = 0; i < NCLIENT; i++) {
+        clients[i] = (client_t){.svc = svc, .seed = i + 1};
+        assert(pthread_create(&threads[i], NULL, client_main,
+                              &clients[i]) == 0);
+    }
+    for (size_t i = 0; i < NCLIENT; i++) {
+        pthread_join(threads[i], NULL);
+        nfail += clients[i].nfail;
+    }
+    utf8_service_free(svc);
+    test_case("Results of concurrent clients", 0, nfail);
+}
+
+int main(void)
+{
+    utf8_service_t *svc = utf8_service_new(1);
+
+    assert(svc);
+
+    // Run all test categories
+    test_parameter_errors(svc);
+    test_wait(svc);
+    utf8_service_free(svc);
+    test_callback();
+    test_concurrent();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
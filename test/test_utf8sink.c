@@ -0,0 +1,281 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/utf8escape.h"
+#include "../src/utf8sink.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXLEN 200
+#define NRAND  500
+
+typedef size_t (*transform_t)(unsigned char *, const unsigned char *, size_t);
+typedef size_t (*sink_transform_t)(utf8_sink_t *, const unsigned char *,
+                                   size_t);
+
+static const struct {
+    const char *name;
+    transform_t fn;
+    sink_transform_t sink_fn;
+} transforms[] = {
+    {"sanitize", utf8_sanitize, utf8_sanitize_sink},
+    {"escape", utf8_escape, utf8_escape_sink},
+    {"surrogateescape decode", utf8_surrogateescape_decode,
+     utf8_surrogateescape_decode_sink},
+};
+
+#define NTRANSFORM (sizeof(transforms) / sizeof(*transforms))
+
+// collects the output of a callback sink
+typedef struct {
+    unsigned char data[MAXLEN * 4];
+    size_t len;
+    size_t ncall;
+} collect_t;
+
+static int collect(void *ctx, const unsigned char *p, size_t n)
+{
+    collect_t *c = ctx;
+
+    memcpy(c->data + c->len, p, n);
+    c->len += n;
+    c->ncall++;
+    return 0;
+}
+
+static int fail_write(void *ctx, const unsigned char *p, size_t n)
+{
+    (void)ctx;
+    (void)p;
+    (void)n;
+    errno = EIO;
+    return -1;
+}
+
+// Test helper function
+static void test_case(const char *desc, const unsigned char *expected,
+                      size_t explen, const unsigned char *actual,
+                      size_t actlen, int verbose)
+{
+    if (explen != actlen || memcmp(expected, actual, explen) != 0) {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected %zu bytes, got %zu bytes\n", explen, actlen);
+        exit(1);
+    }
+    if (verbose) {
+        printf("PASS: %s\n", desc);
+    }
+}
+
+// run each transform into each kind of sink and compare with the array
+// version
+static void check_sinks(const unsigned char *s, size_t len, int verbose)
+{
+    for (size_t t = 0; t < NTRANSFORM; t++) {
+        unsigned char expected[MAXLEN * 4];
+        unsigned char buf[MAXLEN * 4];
+        size_t explen = transforms[t].fn(expected, s, len);
+        utf8_sink_t sink;
+        utf8_arena_t arena;
+        collect_t out = {.len = 0};
+        unsigned char *res = NULL;
+        size_t reslen      = 0;
+        char desc[80];
+
+        snprintf(desc, sizeof(desc), "%s into a fixed buffer",
+                 transforms[t].name);
+        utf8_sink_fixed(&sink, buf, explen);
+        assert(transforms[t].sink_fn(&sink, s, len) == explen);
+        test_case(desc, expected, explen, buf, sink.len, verbose);
+
+        if (explen) {
+            utf8_sink_fixed(&sink, buf, explen - 1);
+            assert(transforms[t].sink_fn(&sink, s, len) == SIZE_MAX &&
+                   errno == ENOBUFS);
+        }
+
+        // small blocks and allocations between writes force both growth in
+        // place and moves
+        snprintf(desc, sizeof(desc), "%s into a builder", transforms[t].name);
+        utf8_arena_init(&arena, 100);
+        utf8_sink_builder(&sink, &arena);
+        assert(utf8_sink_write(&sink, (const unsigned char *)"<", 1) == 0);
+        assert(utf8_arena_alloc(&arena, 7));
+        assert(transforms[t].sink_fn(&sink, s, len) == explen);
+        assert(utf8_arena_alloc(&arena, 3));
+        assert(utf8_sink_write(&sink, (const unsigned char *)">", 1) == 0);
+        res = utf8_sink_finish(&sink, &reslen);
+        assert(res && reslen == explen + 2 && res[reslen] == '\0');
+        test_case(desc, expected, explen, res + 1, reslen - 2, verbose);
+        utf8_arena_free(&arena);
+
+        snprintf(desc, sizeof(desc), "%s into a callback",
+                 transforms[t].name);
+        utf8_sink_callback(&sink, collect, &out, buf, 4 + len % 13);
+        assert(transforms[t].sink_fn(&sink, s, len) == explen);
+        assert(utf8_sink_flush(&sink) == 0);
+        assert(utf8_sink_size(&sink) == explen);
+        test_case(desc, expected, explen, out.data, out.len, verbose);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    unsigned char buf[8];
+    utf8_sink_t sink;
+
+    printf("\n=== Testing parameter errors ===\n");
+    utf8_sink_fixed(&sink, buf, sizeof(buf));
+    assert(utf8_sanitize_sink(NULL, buf, 1) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_escape_sink(&sink, NULL, 1) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_surrogateescape_decode_sink(&sink, NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_surrogateescape_encode_sink(&sink, NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+    assert(utf8_escape_sink(&sink, NULL, 0) == 0 && sink.len == 0);
+    printf("PASS: empty input\n");
+}
+
+// Test the transforms on fixed inputs
+static void test_transforms(void)
+{
+    static const char *inputs[] = {
+        "",
+        "plain ASCII",
+        "back\\slash",
+        "caf\xC3\xA9 \xF0\x9F\x98\x82",
+        "bad \xFF\xFE bytes \xC3",
+        "\xE0\x80\x80 overlong and \xED\xA0\x80 surrogate",
+    };
+
+    printf("\n=== Testing transforms into sinks ===\n");
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); i++) {
+        check_sinks((const unsigned char *)inputs[i], strlen(inputs[i]), 1);
+    }
+}
+
+// Test random inputs against the array versions
+static void test_random(void)
+{
+    unsigned char s[MAXLEN];
+
+    printf("\n=== Testing random inputs ===\n");
+    srand(1);
+    for (int n = 0; n < NRAND; n++) {
+        size_t len = (size_t)rand() % MAXLEN;
+
+        for (size_t i = 0; i < len; i++) {
+            int r = rand() % 8;
+            s[i]  = (unsigned char)(r < 5 ? 'a' + rand() % 26
+                                          : r < 6 ? '\\' : 0x80 + rand() % 128);
+        }
+        check_sinks(s, len, 0);
+    }
+    printf("PASS: %d random inputs\n", NRAND);
+}
+
+// Test surrogateescape round trips through sinks
+static void test_encode(void)
+{
+    const unsigned char *s = (const unsigned char *)"a\xFF" "b\x80\xC3";
+    unsigned char mid[32];
+    unsigned char out[32];
+    utf8_sink_t sink;
+    size_t midlen = 0;
+
+    printf("\n=== Testing surrogateescape encode ===\n");
+    utf8_sink_fixed(&sink, mid, sizeof(mid));
+    midlen = utf8_surrogateescape_decode_sink(&sink, s, 5);
+    utf8_sink_fixed(&sink, out, sizeof(out));
+    assert(utf8_surrogateescape_encode_sink(&sink, mid, midlen) == 5);
+    test_case("Round trip", s, 5, out, sink.len, 1);
+
+    utf8_sink_fixed(&sink, out, sizeof(out));
+    assert(utf8_surrogateescape_encode_sink(
+               &sink, (const unsigned char *)"a\xFF", 2) == SIZE_MAX &&
+           errno == EILSEQ);
+    printf("PASS: illegal byte sequence\n");
+}
+
+// Test arenas, callback bypass and errors
+static void test_sinks(void)
+{
+    unsigned char big[1000];
+    unsigned char buf[16];
+    utf8_arena_t arena;
+    utf8_sink_t sink;
+    utf8_sink_t fdsink;
+    collect_t out = {.len = 0};
+    FILE *f       = tmpfile();
+
+    printf("\n=== Testing sinks ===\n");
+    utf8_arena_init(&arena, 0);
+    for (size_t n = 1; n < 100; n += 7) {
+        unsigned char *p = utf8_arena_alloc(&arena, n);
+
+        assert(p && (uintptr_t)p % UTF8_ARENA_ALIGN == 0);
+        memset(p, 0xAA, n);
+    }
+    assert(utf8_arena_alloc(&arena, UTF8_ARENA_BLOCK * 2));
+    utf8_arena_free(&arena);
+    assert(arena.head == NULL);
+    printf("PASS: arena alignment and large allocations\n");
+
+    // a builder that is the last allocation grows in place
+    utf8_arena_init(&arena, 4096);
+    utf8_sink_builder(&sink, &arena);
+    memset(big, 'x', sizeof(big));
+    assert(utf8_sink_write(&sink, big, 10) == 0);
+    {
+        unsigned char *first = sink.buf;
+
+        assert(utf8_sink_write(&sink, big, sizeof(big)) == 0);
+        assert(sink.buf == first);
+    }
+    assert(utf8_sink_finish(&sink, NULL));
+    assert(arena.head->next == NULL && arena.head->used < 1100);
+    utf8_arena_free(&arena);
+    printf("PASS: builder grows in place\n");
+
+    // writes larger than the buffer bypass it
+    utf8_sink_callback(&sink, collect, &out, buf, sizeof(buf));
+    assert(utf8_sink_write(&sink, (const unsigned char *)"ab", 2) == 0);
+    assert(utf8_sink_write(&sink, big, 100) == 0);
+    assert(out.len == 102 && out.ncall == 2 && sink.len == 0);
+    assert(utf8_sink_finish(&sink, NULL) == NULL && errno == EINVAL);
+    printf("PASS: callback bypass\n");
+
+    utf8_sink_callback(&sink, fail_write, NULL, buf, 4);
+    assert(utf8_escape_sink(&sink, big, 10) == SIZE_MAX && errno == EIO);
+    printf("PASS: callback failure\n");
+
+    assert(f);
+    // a copy of an fd sink writes to the same descriptor
+    utf8_sink_fd(&fdsink, fileno(f), buf, sizeof(buf));
+    sink = fdsink;
+    memset(&fdsink, 0xFF, sizeof(fdsink));
+    assert(utf8_sanitize_sink(&sink, (const unsigned char *)"x\xFFy", 3) == 5);
+    assert(utf8_sink_write(&sink, big, 50) == 0);
+    assert(utf8_sink_flush(&sink) == 0);
+    rewind(f);
+    assert(fread(big, 1, sizeof(big), f) == 55);
+    test_case("File descriptor sink", (const unsigned char *)"x\xEF\xBF\xBDy",
+              5, big, 5, 1);
+    fclose(f);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_transforms();
+    test_random();
+    test_encode();
+    test_sinks();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "../src/utf8split.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXLEN   64
+#define MAXSLICE 16
+
+// Validate a buffer slice by slice and stitch the results
+static size_t validate_slices(const unsigned char *s, const size_t *offsets,
+                              size_t n)
+{
+    utf8_range_t ranges[MAXSLICE];
+
+    for (size_t i = 0; i < n; i++) {
+        size_t illpos =
+            utf8_validate_range(s, offsets[i], offsets[i + 1], &ranges[i]);
+        assert(illpos == ranges[i].illpos);
+    }
+    return utf8_stitch(s, ranges, n);
+}
+
+// Test helper function
+static void test_case(const char *desc, const char *input, size_t len,
+                      size_t n, const size_t *expected)
+{
+    const unsigned char *s = (const unsigned char *)input;
+    size_t offsets[MAXSLICE + 1];
+
+    if (utf8_split(s, len, n, offsets) == n &&
+        memcmp(offsets, expected, (n + 1) * sizeof(*offsets)) == 0 &&
+        validate_slices(s, offsets, n) == utf8_validlen(s, len)) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        for (size_t i = 0; i <= n; i++) {
+            printf("  Expected offset %zu: %zu, got: %zu\n", i, expected[i],
+                   offsets[i]);
+        }
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    size_t offsets[2];
+    utf8_range_t range;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_split(NULL, 1, 1, offsets) == SIZE_MAX && errno == EINVAL);
+    assert(utf8_split((const unsigned char *)"a", 1, 0, offsets) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_split((const unsigned char *)"a", 1, 1, NULL) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_validate_range((const unsigned char *)"ab", 2, 1, &range) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_validate_range((const unsigned char *)"a", 0, 1, NULL) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_stitch((const unsigned char *)"a", &range, 0) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: invalid parameters\n");
+}
+
+// Test cutting at character boundaries
+static void test_split(void)
+{
+    printf("\n=== Testing utf8_split ===\n");
+    test_case("ASCII", "abcdefgh", 8, 4, (const size_t[]){0, 2, 4, 6, 8});
+    test_case("Cuts moved past continuation bytes",
+              "\xE3\x81\x82\xE3\x81\x84\xE3\x81\x86", 9, 3,
+              (const size_t[]){0, 3, 6, 9});
+    test_case("Cuts inside 4 byte characters",
+              "\xF0\x9F\x98\x82\xF0\x9F\x98\x82", 8, 4,
+              (const size_t[]){0, 4, 4, 8, 8});
+    test_case("More slices than bytes", "ab", 2, 4,
+              (const size_t[]){0, 0, 1, 1, 2});
+    test_case("Empty buffer", "", 0, 2, (const size_t[]){0, 0, 0});
+    test_case("Continuation bytes only", "\x80\x80\x80\x80\x80\x80", 6, 2,
+              (const size_t[]){0, 6, 6});
+}
+
+// Test the stitched results of slices cut anywhere
+static void test_validate_range(void)
+{
+    static const char alphabet[] = "a\x80\x82\x90\x9F\xA0\xBF\xC0\xC3\xE0"
+                                   "\xE3\xED\xF0\xF3\xF4\xF5";
+    unsigned char s[MAXLEN];
+    size_t offsets[MAXSLICE + 1];
+    utf8_range_t range;
+    unsigned int seed = 7;
+
+    printf("\n=== Testing utf8_validate_range ===\n");
+    assert(utf8_validate_range((const unsigned char *)"\x82" "ab\xE3\x81", 0,
+                               5, &range) == 0);
+    assert(utf8_validate_range((const unsigned char *)"\x82" "ab\xE3\x81", 1,
+                               5, &range) == 5 &&
+           range.head == 0 && range.tail == 2);
+    assert(utf8_validate_range((const unsigned char *)"\xE3\x81\x82" "a", 1,
+                               4, &range) == 4 &&
+           range.head == 2 && range.tail == 0);
+    assert(utf8_validate_range((const unsigned char *)"a\xE0\x80", 0, 3,
+                               &range) == 1 &&
+           range.tail == 0);
+    printf("PASS: partial characters at both ends\n");
+
+    for (int i = 0; i < 200000; i++) {
+        size_t len  = 0;
+        size_t n    = 0;
+        size_t got  = 0;
+        size_t want = 0;
+
+        seed = seed * 1103515245 + 12345;
+        len  = (seed >> 16) % MAXLEN;
+        for (size_t j = 0; j < len; j++) {
+            seed = seed * 1103515245 + 12345;
+            s[j] =
+                (unsigned char)alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+        }
+        // random cuts, not aligned to characters
+        seed       = seed * 1103515245 + 12345;
+        n          = (seed >> 16) % MAXSLICE + 1;
+        offsets[0] = 0;
+        for (size_t j = 1; j < n; j++) {
+            seed       = seed * 1103515245 + 12345;
+            offsets[j] = offsets[j - 1] +
+                         (len - offsets[j - 1]) * ((seed >> 16) % 4) / 8;
+        }
+        offsets[n] = len;
+
+        got  = validate_slices(s, offsets, n);
+        want = utf8_validlen(s, len);
+        if (got != want) {
+            printf("FAIL: Random slices\n");
+            printf("  Expected: %zu, got: %zu\n", want, got);
+            exit(1);
+        }
+    }
+    printf("PASS: Random slices give the result of utf8_validlen\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_split();
+    test_validate_range();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
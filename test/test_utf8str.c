@@ -0,0 +1,98 @@
+#include "../src/utf8str.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *input, size_t len,
+                      int expected_valid, int expected_ascii,
+                      size_t expected_nchar, size_t expected_nutf16,
+                      size_t expected_illpos)
+{
+    utf8_str_t str;
+
+    utf8_str_init(&str, (const unsigned char *)input, len);
+    if (utf8_str_valid(&str) == expected_valid &&
+        utf8_str_ascii(&str) == expected_ascii &&
+        utf8_str_count(&str) == expected_nchar &&
+        utf8_str_utf16len(&str) == expected_nutf16 &&
+        utf8_str_illpos(&str) == expected_illpos) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected valid: %d, got: %d\n", expected_valid,
+               utf8_str_valid(&str));
+        printf("  Expected ascii: %d, got: %d\n", expected_ascii,
+               utf8_str_ascii(&str));
+        printf("  Expected nchar: %zu, got: %zu\n", expected_nchar,
+               utf8_str_count(&str));
+        printf("  Expected nutf16: %zu, got: %zu\n", expected_nutf16,
+               utf8_str_utf16len(&str));
+        printf("  Expected illpos: %zu, got: %zu\n", expected_illpos,
+               utf8_str_illpos(&str));
+        exit(1);
+    }
+}
+
+// Test metadata of valid strings
+static void test_valid(void)
+{
+    printf("\n=== Testing valid strings ===\n");
+
+    test_case("Empty string", "", 0, 1, 1, 0, 0, 0);
+    test_case("ASCII string", "hello, world", 12, 1, 1, 12, 12, 12);
+    test_case("2-byte and 3-byte characters", "\xC3\xA9\xE3\x81\x82", 5, 1, 0,
+              2, 2, 5);
+    test_case("4-byte characters need surrogate pairs",
+              "a\xF0\x9F\x98\x82" "b", 6, 1, 0, 3, 4, 6);
+    test_case("Long mixed string", "0123456789\xE4\xB8\xAD" "0123456789", 23,
+              1, 0, 21, 21, 23);
+}
+
+// Test metadata of invalid strings
+static void test_invalid(void)
+{
+    printf("\n=== Testing invalid strings ===\n");
+
+    test_case("Illegal byte", "ab\xFF" "c", 4, 0, 0, 4, 4, 2);
+    test_case("Illegal run counts as one character", "a\xED\xA0\x80" "b", 5, 0,
+              0, 3, 3, 1);
+    test_case("Truncated sequence at the end", "0123456789\xF0\x9F\x98", 13, 0,
+              0, 11, 11, 10);
+}
+
+// Test that the metadata is cached
+static void test_cache(void)
+{
+    unsigned char buf[] = "abc";
+    utf8_str_t str;
+
+    printf("\n=== Testing cached metadata ===\n");
+
+    utf8_str_init(&str, buf, 3);
+    assert(str.flags == 0);
+    assert(utf8_str_count(&str) == 3);
+    assert(str.flags & UTF8_STR_SCANNED);
+
+    // the cache is not invalidated by changing the buffer
+    buf[0] = 0xFF;
+    assert(utf8_str_valid(&str));
+    printf("PASS: metadata is computed once\n");
+
+    utf8_str_init(&str, buf, 3);
+    assert(!utf8_str_valid(&str));
+    printf("PASS: initialization clears the cache\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_valid();
+    test_invalid();
+    test_cache();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "../src/utf8escape.h"
+#include "../src/utf8stream.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXLEN 64
+
+// Sanitize a string in chunks of the given sizes, repeating the last size
+static size_t sanitize_chunks(unsigned char *dst, const unsigned char *s,
+                              size_t len, const size_t *sizes, size_t nsize)
+{
+    utf8_stream_t st;
+    size_t n   = 0;
+    size_t pos = 0;
+
+    utf8_stream_init(&st);
+    for (size_t i = 0; pos < len; i += i + 1 < nsize) {
+        size_t clen = sizes[i] < len - pos ? sizes[i] : len - pos;
+        size_t wlen = utf8_stream_sanitize(&st, dst + n, s + pos, clen);
+
+        assert(wlen <= utf8_stream_sanitize_max(clen));
+        n += wlen;
+        pos += clen;
+    }
+    return n + utf8_stream_finish(&st, dst + n);
+}
+
+// Compare the output of every split of a string with utf8_sanitize()
+static void check_splits(const char *desc, const char *input, size_t len)
+{
+    const unsigned char *s = (const unsigned char *)input;
+    unsigned char expected[MAXLEN * 3];
+    unsigned char buf[MAXLEN * 6];
+    size_t expected_len = utf8_sanitize(expected, s, len);
+
+    // every split into two chunks, and chunks of every fixed size
+    for (size_t i = 0; i <= len; i++) {
+        size_t sizes[2] = {i, len};
+        size_t n        = sanitize_chunks(buf, s, len, sizes, 2);
+        size_t fixed    = i ? i : 1;
+        size_t m        = sanitize_chunks(buf + n, s, len, &fixed, 1);
+
+        if (n != expected_len || m != expected_len ||
+            memcmp(buf, expected, n) != 0 ||
+            memcmp(buf + n, expected, m) != 0) {
+            printf("FAIL: %s\n", desc);
+            printf("  Expected len: %zu, got: %zu and %zu with chunk size "
+                   "%zu\n",
+                   expected_len, n, m, i);
+            exit(1);
+        }
+    }
+}
+
+// Test helper function
+static void test_case(const char *desc, const char *input, size_t len)
+{
+    check_splits(desc, input, len);
+    printf("PASS: %s\n", desc);
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    utf8_stream_t st;
+    unsigned char buf[8];
+
+    printf("\n=== Testing parameter errors ===\n");
+    utf8_stream_init(&st);
+    assert(utf8_stream_sanitize(NULL, buf, (const unsigned char *)"a", 1) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_stream_sanitize(&st, NULL, (const unsigned char *)"a", 1) ==
+               SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_stream_sanitize(&st, buf, NULL, 1) == SIZE_MAX &&
+           errno == EINVAL);
+    assert(utf8_stream_finish(NULL, buf) == SIZE_MAX && errno == EINVAL);
+    printf("PASS: NULL parameters\n");
+
+    assert(utf8_stream_sanitize(&st, buf, NULL, 0) == 0);
+    assert(utf8_stream_finish(&st, buf) == 0);
+    printf("PASS: empty input\n");
+}
+
+// Test the state at the end of a chunk
+static void test_state(void)
+{
+    utf8_stream_t st;
+    unsigned char buf[16];
+
+    printf("\n=== Testing stream state ===\n");
+    utf8_stream_init(&st);
+    assert(utf8_stream_sanitize(&st, buf, (const unsigned char *)"a\xE3\x81",
+                                3) == 1 &&
+           !utf8_stream_clean(&st));
+    assert(utf8_stream_sanitize(&st, buf, (const unsigned char *)"\x82", 1) ==
+               3 &&
+           memcmp(buf, "\xE3\x81\x82", 3) == 0 && utf8_stream_clean(&st));
+    printf("PASS: character cut off by a chunk\n");
+
+    assert(utf8_stream_sanitize(&st, buf, (const unsigned char *)"\x80\x80",
+                                2) == 3 &&
+           !utf8_stream_clean(&st));
+    assert(utf8_stream_sanitize(&st, buf, (const unsigned char *)"\xBF", 1) ==
+           0);
+    assert(utf8_stream_sanitize(&st, buf, (const unsigned char *)"\xBF" "a",
+                                2) == 1 &&
+           buf[0] == 'a' && utf8_stream_clean(&st));
+    printf("PASS: illegal bytes across chunks are replaced once\n");
+
+    assert(utf8_stream_sanitize(&st, buf, (const unsigned char *)"\xF0\x9F",
+                                2) == 0);
+    assert(utf8_stream_finish(&st, buf) == 3 &&
+           memcmp(buf, "\xEF\xBF\xBD", 3) == 0 && utf8_stream_clean(&st));
+    printf("PASS: cut off character at the end of the input\n");
+}
+
+// Test that any split gives the output of utf8_sanitize()
+static void test_splits(void)
+{
+    static const char alphabet[] = "a\n\x80\xBF\xC0\xC3\xE0\xE3\xED\xF0\xF4"
+                                   "\xF5\xFF\x90\xA0";
+    unsigned char s[MAXLEN];
+    unsigned int seed = 2024;
+
+    printf("\n=== Testing splits ===\n");
+    test_case("ASCII", "hello, world", 12);
+    test_case("Multibyte characters", "\xC3\xA9\xE3\x81\x82\xF0\x9F\x98\x82",
+              9);
+    test_case("Truncated sequences", "\xE3\x81" "a\xF0\x9F\x98" "b\xC3", 9);
+    test_case("Illegal first bytes", "\x80\x80\x80" "a\xFF\xFE\xC0\xC1" "b", 9);
+    test_case("Surrogates and overlongs", "\xED\xA0\x80\xE0\x80\x80\xF4\x90",
+              8);
+    test_case("Illegal continuation", "\xE3\xC0\x80\x80" "a\xF0\x80\x80\x80",
+              9);
+
+    for (int i = 0; i < 2000; i++) {
+        size_t len = 0;
+
+        seed = seed * 1103515245 + 12345;
+        len  = (seed >> 16) % MAXLEN;
+        for (size_t j = 0; j < len; j++) {
+            seed = seed * 1103515245 + 12345;
+            s[j] = (unsigned char)alphabet[(seed >> 16) %
+                                           (sizeof(alphabet) - 1)];
+        }
+        check_splits("Random bytes", (const char *)s, len);
+    }
+    printf("PASS: Random bytes\n");
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_state();
+    test_splits();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
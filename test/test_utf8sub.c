@@ -0,0 +1,100 @@
+#include "../src/utf8sub.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// "aあbいcうdえeお" (5 ASCII and 5 3-byte characters, 20 bytes)
+#define MIXED "a\xE3\x81\x82" "b\xE3\x81\x84" "c\xE3\x81\x86" "d\xE3\x81\x88" \
+              "e\xE3\x81\x8A"
+
+// Test helper function
+static void test_case(const char *desc, const char *input, ptrdiff_t start,
+                      size_t count, size_t expected_off, size_t expected_len)
+{
+    size_t sublen = 0;
+    size_t off =
+        utf8_sub((const unsigned char *)input, strlen(input), start, count,
+                 &sublen);
+
+    if (off == expected_off && sublen == expected_len) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected offset: %zu, got: %zu\n", expected_off, off);
+        printf("  Expected length: %zu, got: %zu\n", expected_len, sublen);
+        exit(1);
+    }
+}
+
+// Test parameter error handling
+static void test_parameter_errors(void)
+{
+    size_t sublen = 0;
+
+    printf("\n=== Testing parameter errors ===\n");
+    assert(utf8_sub(NULL, 1, 0, 1, &sublen) == SIZE_MAX && errno == EINVAL);
+    printf("PASS: NULL string parameter\n");
+    assert(utf8_sub((const unsigned char *)"a", 1, 0, 1, NULL) == SIZE_MAX &&
+           errno == EINVAL);
+    printf("PASS: NULL sublen parameter\n");
+    assert(utf8_count(NULL, 1) == SIZE_MAX && errno == EINVAL);
+    printf("PASS: NULL count parameter\n");
+}
+
+// Test character counting
+static void test_count(void)
+{
+    printf("\n=== Testing utf8_count ===\n");
+
+    assert(utf8_count((const unsigned char *)"", 0) == 0);
+    assert(utf8_count((const unsigned char *)"hello", 5) == 5);
+    assert(utf8_count((const unsigned char *)MIXED, 20) == 10);
+    assert(utf8_count((const unsigned char *)"\xF0\x9F\x98\x82\xF0\x9F\x98\x82"
+                                             "\xF0\x9F\x98\x82",
+                      12) == 3);
+    printf("PASS: counts of ASCII, mixed and 4-byte text\n");
+}
+
+// Test positions from the beginning
+static void test_forward(void)
+{
+    printf("\n=== Testing forward positions ===\n");
+
+    test_case("Whole string", MIXED, 0, SIZE_MAX, 0, 20);
+    test_case("Empty count", MIXED, 3, 0, 5, 0);
+    test_case("LEFT(s, 2)", MIXED, 0, 2, 0, 4);
+    test_case("Middle across words", MIXED, 3, 4, 5, 8);
+    test_case("Last character", MIXED, 9, 1, 17, 3);
+    test_case("Start beyond the end", MIXED, 10, 3, 20, 0);
+    test_case("Count beyond the end", MIXED, 8, 100, 16, 4);
+    test_case("Long ASCII string", "0123456789abcdefghijklmnopqrstuvwxyz", 17,
+              9, 17, 9);
+}
+
+// Test positions from the end
+static void test_backward(void)
+{
+    printf("\n=== Testing backward positions ===\n");
+
+    test_case("RIGHT(s, 1)", MIXED, -1, 1, 17, 3);
+    test_case("RIGHT(s, 3)", MIXED, -3, 3, 13, 7);
+    test_case("From end across words", MIXED, -8, 2, 4, 4);
+    test_case("First character from the end", MIXED, -10, 1, 0, 1);
+    test_case("Start before the beginning", MIXED, -20, 2, 0, 4);
+    test_case("Long ASCII string", "0123456789abcdefghijklmnopqrstuvwxyz", -19,
+              2, 17, 2);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_parameter_errors();
+    test_count();
+    test_forward();
+    test_backward();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
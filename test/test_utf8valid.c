@@ -0,0 +1,63 @@
+#include "../src/utf8valid.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test helper function
+static void test_case(const char *desc, const char *input, size_t len,
+                      size_t expected_asciilen, size_t expected_validlen)
+{
+    const unsigned char *s = (const unsigned char *)input;
+    size_t asciilen        = utf8_asciilen(s, len);
+    size_t validlen        = utf8_validlen(s, len);
+
+    if (asciilen == expected_asciilen && validlen == expected_validlen) {
+        printf("PASS: %s\n", desc);
+    } else {
+        printf("FAIL: %s\n", desc);
+        printf("  Expected asciilen: %zu, got: %zu\n", expected_asciilen,
+               asciilen);
+        printf("  Expected validlen: %zu, got: %zu\n", expected_validlen,
+               validlen);
+        exit(1);
+    }
+}
+
+// Test short buffers
+static void test_short_buffers(void)
+{
+    printf("\n=== Testing short buffers ===\n");
+
+    test_case("Empty buffer", "", 0, 0, 0);
+    test_case("ASCII only", "hello", 5, 5, 5);
+    test_case("Embedded NUL", "a\0b", 3, 3, 3);
+    test_case("Multi-byte characters", "a\xC3\xA9\xE3\x81\x82", 6, 1, 6);
+    test_case("Illegal byte after ASCII", "ab\x80", 3, 2, 2);
+    test_case("Truncated sequence at the end", "ab\xE3\x81", 4, 2, 2);
+}
+
+// Test buffers longer than a word
+static void test_long_buffers(void)
+{
+    printf("\n=== Testing long buffers ===\n");
+
+    test_case("ASCII across words", "0123456789abcdefghij", 20, 20, 20);
+    test_case("Non-ASCII in the second word", "01234567890\xC3\xA9xyz", 16, 11,
+              16);
+    test_case("Illegal byte in the third word",
+              "0123456789abcdef\xF0\x9F\x98\x82xyz\xFF", 24, 16, 23);
+    test_case("Valid 4-byte characters only",
+              "\xF0\x9F\x98\x82\xF0\x9F\x98\x82\xF0\x9F\x98\x82", 12, 0, 12);
+}
+
+int main(void)
+{
+    // Run all test categories
+    test_short_buffers();
+    test_long_buffers();
+
+    printf("\nAll tests passed successfully!\n");
+    return 0;
+}
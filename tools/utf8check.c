@@ -0,0 +1,366 @@
+//
+// utf8check: validate every regular file under the given paths.
+//
+//  usage: utf8check [-q] [-j threads] [path ...]
+//
+// Directories are walked in parallel by a pool of threads. Each thread owns a
+// deque of paths: it pushes the entries of the directories it reads and pops
+// them from the same end, and a thread whose deque is empty steals from the
+// other end of the deque of another thread, so the walk of a deep or a wide
+// tree is spread over all threads. Small files are read with a single
+// read(2) into a buffer owned by the thread; larger files are mapped.
+//
+// One line is printed for each file (only for invalid files with -q):
+//
+//  path: size bytes, valid
+//  path: size bytes, N illegal byte sequences, first at offset
+//
+// Lines are printed in no particular order. The exit status is 0 if all files
+// are valid, 1 if any file is invalid, and 2 on errors.
+//
+#define _GNU_SOURCE
+#include "../src/utf8valid.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// files larger than this are mapped instead of read
+#define MMAP_MIN   (256 * 1024)
+#define MAXTHREADS 256
+
+typedef struct {
+    char *path;
+    int dir;
+} task_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    task_t *tasks;
+    size_t head;
+    size_t tail;
+    size_t cap;
+    pthread_t thread;
+    unsigned char *buf;
+    size_t ninvalid;
+    size_t nerror;
+} worker_t;
+
+static worker_t workers[MAXTHREADS];
+static size_t nworker;
+static int quiet;
+
+// number of tasks pushed and not finished yet
+static size_t pending;
+// number of pushes, to detect a push while a worker goes idle
+static size_t npushed;
+static size_t nidle;
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_cond  = PTHREAD_COND_INITIALIZER;
+
+static void wake_idle(void)
+{
+    pthread_mutex_lock(&idle_lock);
+    pthread_cond_broadcast(&idle_cond);
+    pthread_mutex_unlock(&idle_lock);
+}
+
+static void push(worker_t *w, char *path, int dir)
+{
+    __atomic_add_fetch(&pending, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&w->lock);
+    if (w->tail == w->cap) {
+        if (w->head) {
+            memmove(w->tasks, w->tasks + w->head,
+                    (w->tail - w->head) * sizeof(*w->tasks));
+            w->tail -= w->head;
+            w->head = 0;
+        } else {
+            size_t cap     = w->cap ? w->cap * 2 : 64;
+            task_t *tasks = realloc(w->tasks, cap * sizeof(*tasks));
+            if (!tasks) {
+                perror("utf8check");
+                exit(2);
+            }
+            w->tasks = tasks;
+            w->cap   = cap;
+        }
+    }
+    w->tasks[w->tail++] = (task_t){path, dir};
+    pthread_mutex_unlock(&w->lock);
+
+    __atomic_add_fetch(&npushed, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&nidle, __ATOMIC_SEQ_CST)) {
+        wake_idle();
+    }
+}
+
+// the owner takes the newest task, so a walk goes depth first
+static int pop(worker_t *w, task_t *task)
+{
+    int found = 0;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head) {
+        *task = w->tasks[--w->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return found;
+}
+
+// a thief takes the oldest task, which is closest to the root of the tree
+static int steal(worker_t *w, task_t *task)
+{
+    int found = 0;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head) {
+        *task = w->tasks[w->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return found;
+}
+
+// wait for a task; returns 0 when all tasks are finished
+static int next_task(worker_t *w, task_t *task)
+{
+    size_t self = (size_t)(w - workers);
+
+    for (;;) {
+        size_t seq = __atomic_load_n(&npushed, __ATOMIC_SEQ_CST);
+
+        if (pop(w, task)) {
+            return 1;
+        }
+        for (size_t i = 1; i < nworker; i++) {
+            if (steal(&workers[(self + i) % nworker], task)) {
+                return 1;
+            }
+        }
+
+        pthread_mutex_lock(&idle_lock);
+        __atomic_add_fetch(&nidle, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&pending, __ATOMIC_SEQ_CST) &&
+               __atomic_load_n(&npushed, __ATOMIC_SEQ_CST) == seq) {
+            pthread_cond_wait(&idle_cond, &idle_lock);
+        }
+        __atomic_sub_fetch(&nidle, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&idle_lock);
+        if (!__atomic_load_n(&pending, __ATOMIC_SEQ_CST)) {
+            return 0;
+        }
+    }
+}
+
+static void finish_task(task_t *task)
+{
+    free(task->path);
+    if (__atomic_sub_fetch(&pending, 1, __ATOMIC_SEQ_CST) == 0) {
+        wake_idle();
+    }
+}
+
+static void report_error(worker_t *w, const char *path)
+{
+    fprintf(stderr, "utf8check: %s: %s\n", path, strerror(errno));
+    w->nerror++;
+}
+
+static void check_file(worker_t *w, const char *path)
+{
+    const unsigned char *s = NULL;
+    struct stat st;
+    size_t len    = 0;
+    size_t pos    = 0;
+    size_t first  = 0;
+    size_t nill   = 0;
+    int fd        = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0 || fstat(fd, &st)) {
+        report_error(w, path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    len = (size_t)st.st_size;
+    if (len <= MMAP_MIN) {
+        ssize_t n = read(fd, w->buf, len);
+        if (n < 0) {
+            report_error(w, path);
+            close(fd);
+            return;
+        }
+        // the file may have shrunk since fstat()
+        len = (size_t)n;
+        s   = w->buf;
+    } else {
+        void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            report_error(w, path);
+            close(fd);
+            return;
+        }
+        s = map;
+    }
+    close(fd);
+
+    while (pos < len) {
+        size_t illlen = 0;
+
+        pos += utf8_validlen(s + pos, len - pos);
+        if (pos < len) {
+            if (!nill++) {
+                first = pos;
+            }
+            utf8nclen(s + pos, len - pos, &illlen);
+            pos += illlen;
+        }
+    }
+    if (s != w->buf) {
+        munmap((void *)(uintptr_t)s, len);
+    }
+
+    if (nill) {
+        w->ninvalid++;
+        printf("%s: %zu bytes, %zu illegal byte sequence%s, first at %zu\n",
+               path, len, nill, nill > 1 ? "s" : "", first);
+    } else if (!quiet) {
+        printf("%s: %zu bytes, valid\n", path, len);
+    }
+}
+
+static void walk_dir(worker_t *w, const char *path)
+{
+    DIR *dir            = opendir(path);
+    struct dirent *ent  = NULL;
+    size_t pathlen      = strlen(path);
+
+    if (!dir) {
+        report_error(w, path);
+        return;
+    }
+    while ((ent = readdir(dir))) {
+        size_t namelen = strlen(ent->d_name);
+        int type       = ent->d_type;
+        char *child    = NULL;
+
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+            continue;
+        }
+        child = malloc(pathlen + namelen + 2);
+        if (!child) {
+            perror("utf8check");
+            exit(2);
+        }
+        memcpy(child, path, pathlen);
+        child[pathlen] = '/';
+        memcpy(child + pathlen + 1, ent->d_name, namelen + 1);
+
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (lstat(child, &st) == 0) {
+                type = S_ISDIR(st.st_mode)   ? DT_DIR
+                       : S_ISREG(st.st_mode) ? DT_REG
+                                             : DT_UNKNOWN;
+            }
+        }
+        // symbolic links and special files are skipped
+        if (type == DT_DIR || type == DT_REG) {
+            push(w, child, type == DT_DIR);
+        } else {
+            free(child);
+        }
+    }
+    closedir(dir);
+}
+
+static void *work(void *arg)
+{
+    worker_t *w = arg;
+    task_t task;
+
+    while (next_task(w, &task)) {
+        if (task.dir) {
+            walk_dir(w, task.path);
+        } else {
+            check_file(w, task.path);
+        }
+        finish_task(&task);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    long ncpu         = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t ninvalid   = 0;
+    size_t nerror     = 0;
+    int opt           = 0;
+
+    nworker = ncpu > 0 ? (size_t)ncpu : 1;
+    while ((opt = getopt(argc, argv, "qj:")) != -1) {
+        if (opt == 'q') {
+            quiet = 1;
+        } else if (opt == 'j' && atoi(optarg) > 0) {
+            nworker = (size_t)atoi(optarg);
+        } else {
+            fprintf(stderr, "usage: %s [-q] [-j threads] [path ...]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (nworker > MAXTHREADS) {
+        nworker = MAXTHREADS;
+    }
+
+    for (size_t i = 0; i < nworker; i++) {
+        pthread_mutex_init(&workers[i].lock, NULL);
+        workers[i].buf = malloc(MMAP_MIN);
+        if (!workers[i].buf) {
+            perror("utf8check");
+            return 2;
+        }
+    }
+
+    // the paths of the command line are spread over the workers
+    for (int i = optind; i < argc || i == optind; i++) {
+        const char *path = i < argc ? argv[i] : ".";
+        struct stat st;
+        char *copy = NULL;
+
+        if (stat(path, &st)) {
+            report_error(&workers[0], path);
+            continue;
+        }
+        copy = strdup(path);
+        if (!copy) {
+            perror("utf8check");
+            return 2;
+        }
+        push(&workers[(size_t)(i - optind) % nworker], copy,
+             S_ISDIR(st.st_mode));
+    }
+
+    for (size_t i = 0; i < nworker; i++) {
+        if (pthread_create(&workers[i].thread, NULL, work, &workers[i])) {
+            perror("utf8check");
+            return 2;
+        }
+    }
+    for (size_t i = 0; i < nworker; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ninvalid += workers[i].ninvalid;
+        nerror += workers[i].nerror;
+        free(workers[i].tasks);
+        free(workers[i].buf);
+    }
+    return nerror ? 2 : ninvalid ? 1 : 0;
+}
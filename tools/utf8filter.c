@@ -0,0 +1,215 @@
+//
+// utf8filter: copy stdin to stdout, replacing each illegal byte sequence
+// with U+FFFD.
+//
+//  usage: utf8filter [-c]
+//
+// When stdin is a pipe on Linux, the input is duplicated with tee(2) into a
+// private pipe and only that copy is read for validation; valid spans are
+// then moved from stdin to stdout with splice(2) without passing through
+// user space, and only short regions around illegal byte sequences are read
+// and rewritten. Otherwise, or with -c, the input is copied through a
+// buffer.
+//
+#define _GNU_SOURCE
+#include "../src/utf8stream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BUFSIZE 65536
+// number of bytes rewritten at a time around an illegal byte sequence
+#define REWRITE 256
+
+static unsigned char buf[BUFSIZE];
+static unsigned char out[BUFSIZE * 3 + 3];
+
+static int write_all(int fd, const unsigned char *s, size_t len)
+{
+    while (len) {
+        ssize_t n = write(fd, s, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        s += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int read_all(int fd, unsigned char *s, size_t len)
+{
+    while (len) {
+        ssize_t n = read(fd, s, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        s += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// rewrite a chunk that has been read from the input
+static int rewrite(utf8_stream_t *st, const unsigned char *s, size_t len)
+{
+    return write_all(STDOUT_FILENO, out,
+                     utf8_stream_sanitize(st, out, s, len));
+}
+
+static int copy_filter(utf8_stream_t *st)
+{
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, buf, BUFSIZE);
+        if (n == 0) {
+            return 0;
+        } else if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        } else if (rewrite(st, buf, (size_t)n)) {
+            return -1;
+        }
+    }
+}
+
+#ifdef __linux__
+
+// returns the number of bytes moved, which is less than len on error
+static size_t splice_all(size_t len)
+{
+    size_t moved = 0;
+
+    while (moved < len) {
+        ssize_t n = splice(STDIN_FILENO, NULL, STDOUT_FILENO, NULL,
+                           len - moved, SPLICE_F_MOVE);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        moved += (size_t)n;
+    }
+    return moved;
+}
+
+// The bytes that are consumed from stdin are always the bytes of buf that
+// have been duplicated from it, so they are read into buf again in place.
+//
+// Returns 1 if stdin or stdout does not support splicing; the rest of the
+// input is then to be copied with the same state.
+static int splice_filter(utf8_stream_t *st)
+{
+    int peek[2];
+    int rc = -1;
+
+    if (pipe(peek)) {
+        return 1;
+    }
+    for (;;) {
+        ssize_t n  = tee(STDIN_FILENO, peek[1], BUFSIZE, 0);
+        size_t pos = 0;
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            rc = errno == EINVAL ? 1 : -1;
+            break;
+        } else if (n == 0) {
+            rc = 0;
+            break;
+        } else if (read_all(peek[0], buf, (size_t)n)) {
+            break;
+        }
+
+        while (pos < (size_t)n) {
+            size_t len = (size_t)n - pos;
+            size_t vlen =
+                utf8_stream_clean(st) ? utf8_validlen(buf + pos, len) : 0;
+
+            if (vlen) {
+                size_t moved = splice_all(vlen);
+
+                pos += moved;
+                if (moved == vlen) {
+                    continue;
+                }
+                // stdout does not support splicing; copy the rest of the
+                // chunk
+                len = (size_t)n - pos;
+                if (errno == EINVAL &&
+                    read_all(STDIN_FILENO, buf + pos, len) == 0 &&
+                    rewrite(st, buf + pos, len) == 0) {
+                    rc = 1;
+                }
+                goto done;
+            }
+            // read and rewrite a short region, ending at a first byte if
+            // possible so that it does not cut off a character
+            if (len > REWRITE) {
+                len = REWRITE;
+                while (len > 1 && (buf[pos + len] & 0xC0) == 0x80) {
+                    len--;
+                }
+            }
+            if (read_all(STDIN_FILENO, buf + pos, len) ||
+                rewrite(st, buf + pos, len)) {
+                goto done;
+            }
+            pos += len;
+        }
+    }
+
+done:
+    close(peek[0]);
+    close(peek[1]);
+    return rc;
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    utf8_stream_t st;
+    int copy = argc > 1 && strcmp(argv[1], "-c") == 0;
+    int rc   = 1;
+
+    if (argc > 2 || (argc == 2 && !copy)) {
+        fprintf(stderr, "usage: %s [-c]\n", argv[0]);
+        return 2;
+    }
+
+    utf8_stream_init(&st);
+#ifdef __linux__
+    if (!copy) {
+        struct stat in;
+        if (fstat(STDIN_FILENO, &in) == 0 && S_ISFIFO(in.st_mode)) {
+            rc = splice_filter(&st);
+        }
+    }
+#endif
+    if (rc == 1) {
+        // the copy of the whole input, or the rest of it after splicing
+        // was refused by stdout
+        rc = copy_filter(&st);
+    }
+    if (rc == 0) {
+        rc = write_all(STDOUT_FILENO, out, utf8_stream_finish(&st, out));
+    }
+    if (rc) {
+        perror("utf8filter");
+        return 1;
+    }
+    return 0;
+}